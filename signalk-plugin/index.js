@@ -0,0 +1,153 @@
+// Server-side companion for the SensESP remote relay controller.
+//
+// Relay leases: the controller publishes <relay>.lease values of the form
+// {path, ttl, holder} while it holds a relay on. If a lease is not renewed
+// within its ttl, the plugin switches the relay at `path` off with a PUT.
+// A ttl of 0 releases the lease.
+//
+// Clock sync: PUTs to remoteRelay.clock are answered with the server's wall
+// clock time in milliseconds as the response message, which the controller
+// uses to estimate its clock offset from the round trip.
+//
+// Compact commands: a PUT to remoteRelay.hello with {version, id, paths}
+// registers a controller's path table. Later PUTs to remoteRelay.command
+// with {id, c} carry integers channel * 2 + state, each of which is
+// expanded into a PUT of the boolean state to paths[channel]. A frame with
+// any code that is not a non-negative integer is refused as a whole.
+
+const LEASE_SUFFIX = '.lease'
+const CLOCK_PATH = 'remoteRelay.clock'
+const HELLO_PATH = 'remoteRelay.hello'
+const COMMAND_PATH = 'remoteRelay.command'
+const COMPACT_VERSION = 1
+
+module.exports = function (app) {
+  const plugin = {
+    id: 'signalk-remote-relay-controller',
+    name: 'Remote relay controller companion',
+    description: 'Auto-release leases, clock sync and compact commands for remote relay controllers'
+  }
+
+  // relay path -> {holder, expires}
+  let leases = new Map()
+  let timer = null
+  // controller id -> interned path table
+  let pathTables = new Map()
+
+  function handleLease (value) {
+    if (!value || typeof value.path !== 'string') {
+      return
+    }
+    if (!value.ttl) {
+      leases.delete(value.path)
+      return
+    }
+    leases.set(value.path, {
+      holder: value.holder,
+      expires: Date.now() + value.ttl
+    })
+  }
+
+  function expireLeases (now) {
+    for (const [path, lease] of leases) {
+      if (lease.expires > now) {
+        continue
+      }
+      leases.delete(path)
+      app.debug(`Lease on ${path} held by ${lease.holder} expired`)
+      app.putSelfPath(path, false, (reply) => {
+        if (reply.state === 'COMPLETED' && reply.statusCode !== 200) {
+          app.error(`Releasing ${path} failed: ${reply.message}`)
+        }
+      })
+    }
+  }
+
+  function handleClockPut (context, path, value, callback) {
+    return { state: 'COMPLETED', statusCode: 200, message: String(Date.now()) }
+  }
+
+  function handleHelloPut (context, path, value, callback) {
+    if (!value || value.version !== COMPACT_VERSION ||
+        typeof value.id !== 'string' || !Array.isArray(value.paths)) {
+      return { state: 'COMPLETED', statusCode: 400, message: 'Unsupported' }
+    }
+    pathTables.set(value.id, value.paths)
+    return { state: 'COMPLETED', statusCode: 200 }
+  }
+
+  function handleCommandPut (context, path, value, callback) {
+    const paths = value && typeof value.id === 'string' &&
+      pathTables.get(value.id)
+    if (!paths) {
+      return { state: 'COMPLETED', statusCode: 400, message: 'Unknown id' }
+    }
+    // A malformed frame is refused whole, before any relay is switched.
+    if (!Array.isArray(value.c) ||
+        !value.c.every((code) => Number.isInteger(code) && code >= 0)) {
+      return { state: 'COMPLETED', statusCode: 400, message: 'Bad commands' }
+    }
+    for (const code of value.c) {
+      const target = paths[code >> 1]
+      if (typeof target !== 'string') {
+        continue
+      }
+      app.putSelfPath(target, (code & 1) === 1, (reply) => {
+        if (reply.state === 'COMPLETED' && reply.statusCode !== 200) {
+          app.error(`Command for ${target} failed: ${reply.message}`)
+        }
+      })
+    }
+    return { state: 'COMPLETED', statusCode: 200 }
+  }
+
+  plugin.start = function (options) {
+    leases = new Map()
+    pathTables = new Map()
+    app.registerPutHandler('vessels.self', CLOCK_PATH, handleClockPut,
+      plugin.id)
+    app.registerPutHandler('vessels.self', HELLO_PATH, handleHelloPut,
+      plugin.id)
+    app.registerPutHandler('vessels.self', COMMAND_PATH, handleCommandPut,
+      plugin.id)
+    app.registerDeltaInputHandler((delta, next) => {
+      for (const update of delta.updates || []) {
+        for (const pv of update.values || []) {
+          if (pv.path && pv.path.endsWith(LEASE_SUFFIX)) {
+            handleLease(pv.value)
+          }
+        }
+      }
+      next(delta)
+    })
+    timer = setInterval(() => expireLeases(Date.now()),
+      options.checkInterval || 1000)
+  }
+
+  plugin.stop = function () {
+    clearInterval(timer)
+    timer = null
+    leases.clear()
+    pathTables.clear()
+  }
+
+  plugin.schema = {
+    type: 'object',
+    properties: {
+      checkInterval: {
+        type: 'number',
+        title: 'Lease expiry check interval (ms)',
+        default: 1000
+      }
+    }
+  }
+
+  // Exposed for testing against a mock app object.
+  plugin.handleLease = handleLease
+  plugin.expireLeases = expireLeases
+  plugin.handleClockPut = handleClockPut
+  plugin.handleHelloPut = handleHelloPut
+  plugin.handleCommandPut = handleCommandPut
+
+  return plugin
+}
@@ -0,0 +1,98 @@
+const assert = require('node:assert')
+const { beforeEach, afterEach, test } = require('node:test')
+
+const createPlugin = require('../index')
+const mockApp = require('./mock_app')
+
+const PATHS = [
+  'electrical.switches.relay0.state',
+  null,
+  'electrical.switches.relay2.state'
+]
+
+let app
+let plugin
+
+function hello (value) {
+  return app.put('remoteRelay.hello', value)
+}
+
+function command (value) {
+  return app.put('remoteRelay.command', value)
+}
+
+beforeEach(() => {
+  app = mockApp()
+  plugin = createPlugin(app)
+  plugin.start({})
+  assert.strictEqual(
+    hello({ version: 1, id: 'controller-a', paths: PATHS }).statusCode, 200)
+})
+
+afterEach(() => {
+  plugin.stop()
+})
+
+test('hellos of another version or without a path table are refused', () => {
+  assert.strictEqual(
+    hello({ version: 2, id: 'controller-b', paths: PATHS }).statusCode, 400)
+  assert.strictEqual(hello({ version: 1, paths: PATHS }).statusCode, 400)
+  assert.strictEqual(
+    hello({ version: 1, id: 'controller-b', paths: 'x' }).statusCode, 400)
+  assert.strictEqual(hello(null).statusCode, 400)
+  assert.strictEqual(
+    command({ id: 'controller-b', c: [1] }).statusCode, 400)
+})
+
+test('each code is expanded into a PUT on its path', () => {
+  const reply = command({ id: 'controller-a', c: [1, 4, 0] })
+  assert.strictEqual(reply.statusCode, 200)
+  assert.deepStrictEqual(app.puts, [
+    { path: PATHS[0], value: true },
+    { path: PATHS[2], value: false },
+    { path: PATHS[0], value: false }
+  ])
+})
+
+test('codes for unused or unknown channels are skipped', () => {
+  const reply = command({ id: 'controller-a', c: [3, 5, 40] })
+  assert.strictEqual(reply.statusCode, 200)
+  assert.deepStrictEqual(app.puts, [{ path: PATHS[2], value: true }])
+})
+
+test('a new hello replaces the path table', () => {
+  hello({ version: 1, id: 'controller-a', paths: ['a.state'] })
+  command({ id: 'controller-a', c: [1] })
+  assert.deepStrictEqual(app.puts, [{ path: 'a.state', value: true }])
+})
+
+test('commands from an unknown controller are refused', () => {
+  assert.strictEqual(command({ id: 'controller-b', c: [1] }).statusCode, 400)
+  assert.strictEqual(command({ c: [1] }).statusCode, 400)
+  assert.strictEqual(command(null).statusCode, 400)
+  assert.deepStrictEqual(app.puts, [])
+})
+
+test('malformed frames switch nothing', () => {
+  const frames = [
+    { id: 'controller-a' },
+    { id: 'controller-a', c: 1 },
+    { id: 'controller-a', c: [1, 1.5] },
+    { id: 'controller-a', c: [1, -1] },
+    { id: 'controller-a', c: [1, '3'] },
+    { id: 'controller-a', c: [1, null] }
+  ]
+  for (const frame of frames) {
+    assert.strictEqual(command(frame).statusCode, 400, JSON.stringify(frame))
+  }
+  assert.deepStrictEqual(app.puts, [])
+})
+
+test('a failed expansion is logged', () => {
+  app.putSelfPath = (path, value, callback) => {
+    callback({ state: 'COMPLETED', statusCode: 502, message: 'Bad gateway' })
+  }
+  command({ id: 'controller-a', c: [1] })
+  assert.deepStrictEqual(app.errors,
+    [`Command for ${PATHS[0]} failed: Bad gateway`])
+})
@@ -0,0 +1,94 @@
+const assert = require('node:assert')
+const { beforeEach, afterEach, mock, test } = require('node:test')
+
+const createPlugin = require('../index')
+const mockApp = require('./mock_app')
+
+const RELAY = 'electrical.switches.relay0.state'
+
+function leaseDelta (ttl) {
+  return {
+    updates: [{
+      values: [{
+        path: 'electrical.switches.relay0.lease',
+        value: { path: RELAY, ttl, holder: 'controller-a' }
+      }]
+    }]
+  }
+}
+
+let app
+let plugin
+
+beforeEach(() => {
+  mock.timers.enable({ apis: ['setInterval', 'Date'], now: 1000000 })
+  app = mockApp()
+  plugin = createPlugin(app)
+  plugin.start({ checkInterval: 1000 })
+})
+
+afterEach(() => {
+  plugin.stop()
+  mock.timers.reset()
+})
+
+test('lease deltas are passed on to the server', () => {
+  const delta = leaseDelta(5000)
+  assert.strictEqual(app.handleDelta(delta), delta)
+})
+
+test('a held lease leaves the relay alone', () => {
+  app.handleDelta(leaseDelta(5000))
+  mock.timers.tick(4000)
+  assert.deepStrictEqual(app.puts, [])
+})
+
+test('an expired lease switches the relay off once', () => {
+  app.handleDelta(leaseDelta(5000))
+  mock.timers.tick(6000)
+  assert.deepStrictEqual(app.puts, [{ path: RELAY, value: false }])
+  mock.timers.tick(10000)
+  assert.strictEqual(app.puts.length, 1)
+})
+
+test('renewal extends the lease', () => {
+  app.handleDelta(leaseDelta(5000))
+  mock.timers.tick(4000)
+  app.handleDelta(leaseDelta(5000))
+  mock.timers.tick(4000)
+  assert.deepStrictEqual(app.puts, [])
+  mock.timers.tick(2000)
+  assert.deepStrictEqual(app.puts, [{ path: RELAY, value: false }])
+})
+
+test('a ttl of 0 releases the lease without switching the relay', () => {
+  app.handleDelta(leaseDelta(5000))
+  app.handleDelta(leaseDelta(0))
+  mock.timers.tick(10000)
+  assert.deepStrictEqual(app.puts, [])
+})
+
+test('a failed release is logged', () => {
+  app.putSelfPath = (path, value, callback) => {
+    callback({ state: 'COMPLETED', statusCode: 502, message: 'Bad gateway' })
+  }
+  app.handleDelta(leaseDelta(5000))
+  mock.timers.tick(6000)
+  assert.deepStrictEqual(app.errors, [`Releasing ${RELAY} failed: Bad gateway`])
+})
+
+test('stop drops the held leases', () => {
+  app.handleDelta(leaseDelta(5000))
+  plugin.stop()
+  plugin.start({ checkInterval: 1000 })
+  mock.timers.tick(10000)
+  assert.deepStrictEqual(app.puts, [])
+})
+
+test('the clock endpoint answers with the server time', () => {
+  mock.timers.tick(1234)
+  const reply = app.put('remoteRelay.clock', null)
+  assert.strictEqual(reply.state, 'COMPLETED')
+  assert.strictEqual(reply.statusCode, 200)
+  assert.strictEqual(reply.message, '1001234')
+})
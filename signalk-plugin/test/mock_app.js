@@ -0,0 +1,38 @@
+// Stand-in for the SignalK server's app object, recording what the plugin
+// registers and sends.
+
+module.exports = function mockApp () {
+  const app = {
+    putHandlers: new Map(),
+    deltaInputHandlers: [],
+    puts: [],
+    errors: [],
+    registerPutHandler (context, path, handler, source) {
+      app.putHandlers.set(path, handler)
+    },
+    registerDeltaInputHandler (handler) {
+      app.deltaInputHandlers.push(handler)
+    },
+    putSelfPath (path, value, callback) {
+      app.puts.push({ path, value })
+      callback({ state: 'COMPLETED', statusCode: 200 })
+    },
+    debug () {},
+    error (message) {
+      app.errors.push(message)
+    },
+    // Run a delta through the input handlers, as the server does.
+    handleDelta (delta) {
+      let passed = null
+      for (const handler of app.deltaInputHandlers) {
+        handler(delta, (d) => { passed = d })
+      }
+      return passed
+    },
+    // Send a PUT to the handler registered for the path.
+    put (path, value) {
+      return app.putHandlers.get(path)('vessels.self', path, value, () => {})
+    }
+  }
+  return app
+}
@@ -0,0 +1,83 @@
+#include "actuator_bank.h"
+
+#include "sensesp.h"
+#include "sensesp/system/lambda_consumer.h"
+
+using namespace sensesp;
+
+ActuatorBank::ActuatorBank() {
+  event_loop()->onTick([this]() { commit(); });
+}
+
+void ActuatorBank::add_channel(int channel, int relay_pin,
+                               const char* sk_path) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds actuator bank size", channel);
+    return;
+  }
+  relay_pins_[channel] = relay_pin;
+  sk_paths_[channel] = sk_path;
+  registered_.set(channel);
+  pinMode(relay_pin, OUTPUT);
+  digitalWrite(relay_pin, LOW);
+
+  auto* put_listener = new SKPutRequestListener<bool>(sk_path);
+  put_listener->connect_to(new LambdaConsumer<bool>(
+      [this, channel](bool state) { command(channel, state); }));
+
+  state_outputs_[channel] = new SKOutputBool(sk_path);
+  // Announce the initial state on connect.
+  state_outputs_[channel]->set(false);
+}
+
+void ActuatorBank::command(int channel, bool state) {
+  if (!registered_[channel]) {
+    return;
+  }
+  pending_.set(channel);
+  pending_value_[channel] = state;
+}
+
+bool ActuatorBank::apply_local(const String& sk_path, bool state) {
+  if (registered_.none()) {
+    return false;
+  }
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (registered_[i] && sk_path == sk_paths_[i]) {
+      command(i, state);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ActuatorBank::commit() {
+  if (pending_.none()) {
+    return;
+  }
+  ChannelSet committed = pending_;
+  ChannelSet changed = pending_ & (pending_value_ ^ output_);
+  output_ = (output_ & ~pending_) | (pending_value_ & pending_);
+  pending_.reset();
+
+  // Switch all outputs first, then report; the SignalK outputs end up in
+  // the same outgoing delta.
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (changed[i]) {
+      digitalWrite(relay_pins_[i], output_[i] ? HIGH : LOW);
+    }
+  }
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!committed[i]) {
+      continue;
+    }
+    if (changed[i]) {
+      state_outputs_[i]->set(output_[i]);
+    }
+    // Commands that match the output are confirmed too, so they do not
+    // stay pending.
+    if (commit_callback_) {
+      commit_callback_(i, output_[i]);
+    }
+  }
+}
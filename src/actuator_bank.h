@@ -0,0 +1,56 @@
+// Relay outputs hosted on this device
+//
+// ActuatorBank drives the relay outputs of actuator channels. Each actuator
+// registers as the SignalK PUT handler for its path and reports its state
+// back on the same path. Commands for a path owned by this device, whether
+// from a PUT or from a local button, are applied without a server round
+// trip. All commands received during one tick are applied together in a
+// single output commit at the end of the tick.
+
+#ifndef ACTUATOR_BANK_H_
+#define ACTUATOR_BANK_H_
+
+#include <Arduino.h>
+
+#include <functional>
+
+#include "channel_config.h"
+#include "sensesp/signalk/signalk_output.h"
+#include "sensesp/signalk/signalk_put_request_listener.h"
+
+class ActuatorBank {
+ public:
+  ActuatorBank();
+
+  void add_channel(int channel, int relay_pin, const char* sk_path);
+
+  // Command the relay of an actuator channel; applied on the next commit.
+  void command(int channel, bool state);
+
+  // If sk_path belongs to one of this device's actuators, command it and
+  // return true. Otherwise the command has to go through the server.
+  bool apply_local(const String& sk_path, bool state);
+
+  // Called for each channel committed, whether or not its output changed.
+  void set_commit_callback(std::function<void(int, bool)> callback) {
+    commit_callback_ = callback;
+  }
+
+  bool state(int channel) const { return output_[channel]; }
+
+ private:
+  void commit();
+
+  int relay_pins_[kMaxChannels] = {};
+  const char* sk_paths_[kMaxChannels] = {};
+  sensesp::SKOutputBool* state_outputs_[kMaxChannels] = {};
+
+  ChannelSet registered_;
+  ChannelSet pending_;
+  ChannelSet pending_value_;
+  ChannelSet output_;
+
+  std::function<void(int, bool)> commit_callback_;
+};
+
+#endif  // ACTUATOR_BANK_H_
@@ -0,0 +1,201 @@
+#include "astro_schedule.h"
+
+#include <ArduinoJson.h>
+
+#include <cmath>
+#include <ctime>
+
+#include "clock_sync.h"
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_listener.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr int64_t kDayMs = 86400000;
+constexpr float kDegToRad = M_PI / 180.0;
+
+// Sun altitude of each event, as a zenith angle in degrees.
+constexpr float kZenithDeg[] = {96.0, 90.833, 90.833, 96.0};
+
+class PositionListener : public SKListener {
+ public:
+  PositionListener(AstroSchedule* schedule)
+      : SKListener("navigation.position", 10000), schedule_(schedule) {}
+
+  void parse_value(const JsonObject& json) override {
+    JsonVariant value = json["value"];
+    if (value["latitude"].is<float>() && value["longitude"].is<float>()) {
+      schedule_->set_position(value["latitude"].as<float>(),
+                              value["longitude"].as<float>());
+    }
+  }
+
+ private:
+  AstroSchedule* schedule_;
+};
+
+float normalize(float value, float range) {
+  value = fmodf(value, range);
+  return value < 0 ? value + range : value;
+}
+
+}  // namespace
+
+AstroSchedule::AstroSchedule(unsigned int check_interval_ms) {
+  new PositionListener(this);
+  event_loop()->onRepeat(check_interval_ms, [this]() { check(); });
+}
+
+void AstroSchedule::add_rule(const AstroRule& rule,
+                             std::function<void(bool)> command) {
+  if (num_rules_ >= kMaxRules) {
+    debugE("Schedule rule for channel %d exceeds schedule size", rule.channel);
+    return;
+  }
+  rules_[num_rules_] = rule;
+  commands_[num_rules_] = command;
+  num_rules_++;
+  table_stale_ = true;
+}
+
+void AstroSchedule::set_position(float latitude, float longitude) {
+  latitude_ = latitude;
+  longitude_ = longitude;
+  has_position_ = true;
+  float dlat = latitude - table_latitude_;
+  float dlon = (longitude - table_longitude_) * cosf(latitude * kDegToRad);
+  if (dlat * dlat + dlon * dlon >
+      kRecomputeDistanceDeg * kRecomputeDistanceDeg) {
+    table_stale_ = true;
+  }
+}
+
+// Sunrise equation from the Almanac for Computers (1990), accurate to about
+// a minute.
+int64_t AstroSchedule::event_time_ms(int64_t day_start_ms, float latitude,
+                                     float longitude, SolarEvent event) {
+  time_t day_start_s = day_start_ms / 1000;
+  struct tm date;
+  gmtime_r(&day_start_s, &date);
+  int day_of_year = date.tm_yday + 1;
+  bool rising =
+      event == SolarEvent::kCivilDawn || event == SolarEvent::kSunrise;
+
+  float lng_hour = longitude / 15;
+  float t = day_of_year + ((rising ? 6 : 18) - lng_hour) / 24;
+  float mean_anomaly = 0.9856 * t - 3.289;
+  float true_longitude =
+      normalize(mean_anomaly + 1.916 * sinf(mean_anomaly * kDegToRad) +
+                    0.020 * sinf(2 * mean_anomaly * kDegToRad) + 282.634,
+                360);
+  float right_ascension = normalize(
+      atanf(0.91764 * tanf(true_longitude * kDegToRad)) / kDegToRad, 360);
+  // Same quadrant as the true longitude.
+  right_ascension += floorf(true_longitude / 90) * 90 -
+                     floorf(right_ascension / 90) * 90;
+  right_ascension /= 15;
+
+  float sin_declination = 0.39782 * sinf(true_longitude * kDegToRad);
+  float cos_declination = cosf(asinf(sin_declination));
+  float cos_hour_angle =
+      (cosf(kZenithDeg[static_cast<int>(event)] * kDegToRad) -
+       sin_declination * sinf(latitude * kDegToRad)) /
+      (cos_declination * cosf(latitude * kDegToRad));
+  if (cos_hour_angle > 1 || cos_hour_angle < -1) {
+    // Polar day or night.
+    return -1;
+  }
+  float hour_angle = acosf(cos_hour_angle) / kDegToRad;
+  if (rising) {
+    hour_angle = 360 - hour_angle;
+  }
+  hour_angle /= 15;
+
+  float local_mean_time = hour_angle + right_ascension - 0.06571 * t - 6.622;
+  float utc_hours = normalize(local_mean_time - lng_hour, 24);
+  return day_start_ms + static_cast<int64_t>(utc_hours * 3600000);
+}
+
+void AstroSchedule::build_table(int64_t now_ms) {
+  int64_t today = now_ms - now_ms % kDayMs;
+  table_size_ = 0;
+  for (int64_t day = today; day <= today + kDayMs; day += kDayMs) {
+    for (int r = 0; r < num_rules_; r++) {
+      const AstroRule& rule = rules_[r];
+      for (bool state : {true, false}) {
+        SolarEvent event = state ? rule.on_event : rule.off_event;
+        int64_t time = event_time_ms(day, latitude_, longitude_, event);
+        if (time < 0) {
+          continue;
+        }
+        time += rule.offset_min * 60000;
+        if (time <= now_ms) {
+          continue;
+        }
+        // Insertion sort; the table holds a few dozen entries at most.
+        int i = table_size_++;
+        while (i > 0 && table_[i - 1].time_ms > time) {
+          table_[i] = table_[i - 1];
+          i--;
+        }
+        table_[i] = {time, static_cast<uint8_t>(r), state};
+      }
+    }
+  }
+  next_entry_ = 0;
+  table_valid_until_ms_ = today + kDayMs;
+  table_latitude_ = latitude_;
+  table_longitude_ = longitude_;
+  table_stale_ = false;
+  debugI("Solar schedule: %d events for %.2f, %.2f", table_size_, latitude_,
+         longitude_);
+
+  if (!caught_up_) {
+    catch_up(now_ms);
+    caught_up_ = true;
+  }
+}
+
+void AstroSchedule::catch_up(int64_t now_ms) {
+  int64_t today = now_ms - now_ms % kDayMs;
+  for (int r = 0; r < num_rules_; r++) {
+    const AstroRule& rule = rules_[r];
+    int64_t latest[2] = {-1, -1};  // off, on
+    for (int64_t day = today - kDayMs; day <= today; day += kDayMs) {
+      for (bool state : {true, false}) {
+        SolarEvent event = state ? rule.on_event : rule.off_event;
+        int64_t time = event_time_ms(day, latitude_, longitude_, event);
+        if (time < 0) {
+          continue;
+        }
+        time += rule.offset_min * 60000;
+        if (time <= now_ms && time > latest[state]) {
+          latest[state] = time;
+        }
+      }
+    }
+    if (latest[0] < 0 && latest[1] < 0) {
+      continue;
+    }
+    commands_[r](latest[1] > latest[0]);
+  }
+}
+
+void AstroSchedule::check() {
+  if (!has_position_ || num_rules_ == 0 || clock_sync == nullptr ||
+      !clock_sync->is_synced()) {
+    return;
+  }
+  int64_t now_ms = clock_sync->server_time_ms();
+  if (table_stale_ || now_ms >= table_valid_until_ms_) {
+    build_table(now_ms);
+  }
+  while (next_entry_ < table_size_ && table_[next_entry_].time_ms <= now_ms) {
+    const Entry& entry = table_[next_entry_++];
+    debugI("Solar schedule: channel %d %s", rules_[entry.rule].channel,
+           entry.state ? "on" : "off");
+    commands_[entry.rule](entry.state);
+  }
+}
@@ -0,0 +1,90 @@
+// Channel schedules following sunrise, sunset and civil twilight
+//
+// AstroSchedule switches channels at solar events for the vessel's position,
+// e.g. anchor lights on at sunset and off at sunrise. It subscribes to
+// navigation.position and computes the events of the current and the next
+// UTC day once, into a table sorted by time. The table is recomputed at the
+// end of the day and when the vessel has moved far enough to shift the
+// events by about a minute. Checking the schedule is then a comparison of
+// the next table entry with the clock; no trigonometry runs per tick.
+//
+// Time comes from the server clock estimated by ClockSync, so nothing is
+// switched before the first clock sample. When the first table is built,
+// every rule's channel is set to the state its latest event implies, so the
+// lights are right after a reboot.
+
+#ifndef ASTRO_SCHEDULE_H_
+#define ASTRO_SCHEDULE_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <functional>
+
+enum class SolarEvent : uint8_t {
+  kCivilDawn = 0,
+  kSunrise,
+  kSunset,
+  kCivilDusk,
+};
+
+struct AstroRule {
+  int channel;
+  SolarEvent on_event;
+  SolarEvent off_event;
+  // Shift of both events, e.g. -15 to switch a quarter hour early.
+  int offset_min = 0;
+};
+
+class AstroSchedule {
+ public:
+  static constexpr int kMaxRules = 8;
+  // Distance, in degrees of latitude, that shifts the events by about a
+  // minute.
+  static constexpr float kRecomputeDistanceDeg = 0.25;
+
+  AstroSchedule(unsigned int check_interval_ms = 1000);
+
+  void add_rule(const AstroRule& rule, std::function<void(bool)> command);
+
+  // Position in degrees; normally fed from navigation.position.
+  void set_position(float latitude, float longitude);
+
+  // Time of a solar event on the UTC day starting at day_start_ms, in
+  // milliseconds since the epoch, or -1 if the sun does not cross the
+  // event's altitude that day.
+  static int64_t event_time_ms(int64_t day_start_ms, float latitude,
+                               float longitude, SolarEvent event);
+
+ private:
+  struct Entry {
+    int64_t time_ms;
+    uint8_t rule;
+    bool state;
+  };
+
+  void check();
+  void build_table(int64_t now_ms);
+  void catch_up(int64_t now_ms);
+
+  AstroRule rules_[kMaxRules] = {};
+  std::function<void(bool)> commands_[kMaxRules];
+  int num_rules_ = 0;
+
+  bool has_position_ = false;
+  float latitude_ = 0;
+  float longitude_ = 0;
+  // Position the table was computed for.
+  float table_latitude_ = 0;
+  float table_longitude_ = 0;
+  bool table_stale_ = true;
+  bool caught_up_ = false;
+
+  // Two days of on and off events per rule.
+  Entry table_[kMaxRules * 4] = {};
+  int table_size_ = 0;
+  int next_entry_ = 0;
+  int64_t table_valid_until_ms_ = 0;
+};
+
+#endif  // ASTRO_SCHEDULE_H_
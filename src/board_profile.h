@@ -0,0 +1,48 @@
+// Board profile selected by the PlatformIO environment
+//
+// Every environment in platformio.ini defines one BOARD_* macro, which
+// selects a profile header from boards/. A profile is constexpr data in
+// namespace board:
+//  - kName, the board's name for the log,
+//  - kI2cSda and kI2cScl, or -1 if the board has no I2C bus to start,
+//  - kButtonPins and kLedPins, the button input and status LED output of
+//    each channel slot,
+//  - kHasRelayOutputs and kHasPwm, whether GPIOs are free for actuator
+//    relays and local dimmers,
+//  - kHasTouch and kTouchPins, the touch pad of each channel slot on boards
+//    with touch pads.
+//
+// The channel table in main.cpp takes its pins from the slots, so a table
+// with more channels than the board has slots, or with a role the board
+// cannot drive, fails to compile for that board.
+
+#ifndef BOARD_PROFILE_H_
+#define BOARD_PROFILE_H_
+
+#if defined(BOARD_HALMET)
+#include "boards/halmet.h"
+#elif defined(BOARD_SHESP32)
+#include "boards/shesp32.h"
+#elif defined(BOARD_HALSER)
+#include "boards/halser.h"
+#elif defined(BOARD_ESP32C3_DEVKIT)
+#include "boards/esp32c3_devkit.h"
+#elif defined(BOARD_ESP32_DEVKIT)
+#include "boards/esp32_devkit.h"
+#else
+#error "No board profile; define one of the BOARD_* macros"
+#endif
+
+namespace board {
+
+constexpr int kNumSlots = sizeof(kButtonPins) / sizeof(kButtonPins[0]);
+static_assert(sizeof(kLedPins) == sizeof(kButtonPins),
+              "Every channel slot needs a button and an LED pin");
+static_assert(sizeof(kTouchPins) == sizeof(kButtonPins),
+              "Every channel slot needs a touch pin, or -1");
+
+constexpr bool kHasI2c = kI2cSda >= 0 && kI2cScl >= 0;
+
+}  // namespace board
+
+#endif  // BOARD_PROFILE_H_
@@ -0,0 +1,25 @@
+// Generic ESP32 development board
+
+#ifndef BOARDS_ESP32_DEVKIT_H_
+#define BOARDS_ESP32_DEVKIT_H_
+
+namespace board {
+
+constexpr const char* kName = "ESP32 DevKit";
+
+constexpr int kI2cSda = 21;
+constexpr int kI2cScl = 22;
+
+constexpr int kButtonPins[] = {16, 17, 18, 19};
+constexpr int kLedPins[] = {12, 13, 14, 15};
+
+constexpr bool kHasRelayOutputs = true;
+constexpr bool kHasPwm = true;
+
+// Touch pads that replace the buttons on sealed panels.
+constexpr bool kHasTouch = true;
+constexpr int kTouchPins[] = {4, 27, 32, 33};
+
+}  // namespace board
+
+#endif  // BOARDS_ESP32_DEVKIT_H_
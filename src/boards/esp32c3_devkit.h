@@ -0,0 +1,29 @@
+// Generic ESP32-C3 development board
+//
+// GPIO 8 drives the RGB LED and GPIO 9 is the boot button, and GPIO 18 and
+// 19 are the USB port, which leaves eight pins for four channels and none
+// for I2C.
+
+#ifndef BOARDS_ESP32C3_DEVKIT_H_
+#define BOARDS_ESP32C3_DEVKIT_H_
+
+namespace board {
+
+constexpr const char* kName = "ESP32-C3 DevKit";
+
+constexpr int kI2cSda = -1;
+constexpr int kI2cScl = -1;
+
+constexpr int kButtonPins[] = {0, 1, 3, 4};
+constexpr int kLedPins[] = {5, 6, 7, 10};
+
+// No pins left for relays or dimmers.
+constexpr bool kHasRelayOutputs = false;
+constexpr bool kHasPwm = false;
+
+constexpr bool kHasTouch = false;
+constexpr int kTouchPins[] = {-1, -1, -1, -1};
+
+}  // namespace board
+
+#endif  // BOARDS_ESP32C3_DEVKIT_H_
@@ -0,0 +1,28 @@
+// Hat Labs HALMET
+//
+// The four buttons are wired to the protected digital inputs D1 to D4. The
+// I2C bus also serves the on-board ADC.
+
+#ifndef BOARDS_HALMET_H_
+#define BOARDS_HALMET_H_
+
+namespace board {
+
+constexpr const char* kName = "HALMET";
+
+constexpr int kI2cSda = 21;
+constexpr int kI2cScl = 22;
+
+constexpr int kButtonPins[] = {23, 25, 27, 26};
+constexpr int kLedPins[] = {4, 5, 32, 33};
+
+// The remaining header pins are taken by the status LEDs.
+constexpr bool kHasRelayOutputs = false;
+constexpr bool kHasPwm = false;
+
+constexpr bool kHasTouch = false;
+constexpr int kTouchPins[] = {-1, -1, -1, -1};
+
+}  // namespace board
+
+#endif  // BOARDS_HALMET_H_
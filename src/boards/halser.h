@@ -0,0 +1,28 @@
+// Hat Labs HALSER
+//
+// An ESP32-C3 board. With the serial transceiver and the RGB LED wired up,
+// the header pins are enough for four channels but not for relays or
+// dimmers.
+
+#ifndef BOARDS_HALSER_H_
+#define BOARDS_HALSER_H_
+
+namespace board {
+
+constexpr const char* kName = "HALSER";
+
+constexpr int kI2cSda = -1;
+constexpr int kI2cScl = -1;
+
+constexpr int kButtonPins[] = {0, 1, 3, 4};
+constexpr int kLedPins[] = {5, 6, 7, 10};
+
+constexpr bool kHasRelayOutputs = false;
+constexpr bool kHasPwm = false;
+
+constexpr bool kHasTouch = false;
+constexpr int kTouchPins[] = {-1, -1, -1, -1};
+
+}  // namespace board
+
+#endif  // BOARDS_HALSER_H_
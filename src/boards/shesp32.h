@@ -0,0 +1,27 @@
+// Hat Labs SH-ESP32
+//
+// I2C is on GPIO 16 and 17, so the channels use the header pins the CAN
+// transceiver and the opto-isolated I/O leave free.
+
+#ifndef BOARDS_SHESP32_H_
+#define BOARDS_SHESP32_H_
+
+namespace board {
+
+constexpr const char* kName = "SH-ESP32";
+
+constexpr int kI2cSda = 16;
+constexpr int kI2cScl = 17;
+
+constexpr int kButtonPins[] = {18, 19, 23, 25};
+constexpr int kLedPins[] = {26, 27, 14, 13};
+
+constexpr bool kHasRelayOutputs = true;
+constexpr bool kHasPwm = true;
+
+constexpr bool kHasTouch = false;
+constexpr int kTouchPins[] = {-1, -1, -1, -1};
+
+}  // namespace board
+
+#endif  // BOARDS_SHESP32_H_
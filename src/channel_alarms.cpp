@@ -0,0 +1,158 @@
+#include "channel_alarms.h"
+
+#include <ArduinoJson.h>
+
+#include "clock_sync.h"
+#include "sensesp.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+namespace {
+
+const char* const kAlarmNames[ChannelAlarms::kNumAlarms] = {
+    "commandTimeout", "readbackMismatch", "stuckButton"};
+
+const char* const kAlarmMessages[ChannelAlarms::kNumAlarms] = {
+    "Relay command was not confirmed by the server",
+    "Relay state differs from the last command",
+    "Relay button is stuck"};
+
+}  // namespace
+
+ChannelAlarms::ChannelAlarms(ChannelStore* store,
+                             unsigned int command_timeout_ms,
+                             unsigned int stuck_button_ms,
+                             unsigned int settle_window_ms)
+    : store_(store),
+      command_timeout_ms_(command_timeout_ms),
+      stuck_button_ms_(stuck_button_ms),
+      settle_window_ms_(settle_window_ms) {
+  event_loop()->onRepeat(100, [this]() { check_timers(); });
+  event_loop()->onTick([this]() { flush(); });
+}
+
+void ChannelAlarms::add_channel(int channel,
+                                SKPutRequest<bool>* put_request) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds alarm table size", channel);
+    return;
+  }
+  put_requests_[channel] = put_request;
+  registered_.set(channel);
+}
+
+void ChannelAlarms::state_received(int channel, bool state) {
+  if (!registered_[channel] || store_->pending()[channel]) {
+    // Stale value from before the command; keep waiting.
+    return;
+  }
+  set_alarm(ChannelAlarm::kCommandTimeout, channel, false);
+  if (millis() - store_->commanded_at(channel) > settle_window_ms_) {
+    // Switched elsewhere after the settle window: the new baseline.
+    set_alarm(ChannelAlarm::kReadbackMismatch, channel, false);
+    return;
+  }
+  set_alarm(ChannelAlarm::kReadbackMismatch, channel,
+            store_->commanded(channel) != state);
+}
+
+void ChannelAlarms::button_changed(int channel, bool pressed) {
+  button_down_[channel] = pressed;
+  if (pressed) {
+    button_down_since_[channel] = millis();
+  } else {
+    set_alarm(ChannelAlarm::kStuckButton, channel, false);
+  }
+}
+
+void ChannelAlarms::set_alarm(ChannelAlarm alarm, int channel, bool active) {
+  int kind = static_cast<int>(alarm);
+  if (active_[kind][channel] == active) {
+    return;
+  }
+  active_[kind][channel] = active;
+  dirty_[kind].set(channel);
+  any_dirty_ = true;
+}
+
+void ChannelAlarms::check_timers() {
+  uint32_t now = millis();
+  const int timeout = static_cast<int>(ChannelAlarm::kCommandTimeout);
+  const int mismatch = static_cast<int>(ChannelAlarm::kReadbackMismatch);
+  // A new command supersedes any earlier disagreement.
+  ChannelSet superseded = active_[mismatch] & store_->pending();
+  ChannelSet overdue = store_->scan_pending(command_timeout_ms_, now) &
+                       registered_ & ~active_[timeout];
+  if (superseded.none() && overdue.none() && button_down_.none()) {
+    return;
+  }
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (superseded[i]) {
+      set_alarm(ChannelAlarm::kReadbackMismatch, i, false);
+    }
+    if (overdue[i]) {
+      set_alarm(ChannelAlarm::kCommandTimeout, i, true);
+    }
+    if (button_down_[i] && now - button_down_since_[i] > stuck_button_ms_) {
+      set_alarm(ChannelAlarm::kStuckButton, i, true);
+    }
+  }
+}
+
+void ChannelAlarms::flush() {
+  auto ws_client = sensesp_app->get_ws_client();
+  bool connected = ws_client->is_connected();
+  if (connected && !was_connected_) {
+    // Republish active alarms after every reconnect.
+    for (int kind = 0; kind < kNumAlarms; kind++) {
+      if (active_[kind].any()) {
+        dirty_[kind] |= active_[kind];
+        any_dirty_ = true;
+      }
+    }
+  }
+  was_connected_ = connected;
+  if (!any_dirty_ || !connected) {
+    return;
+  }
+
+  JsonDocument delta;
+  JsonObject update = delta["updates"].add<JsonObject>();
+  if (clock_sync != nullptr) {
+    clock_sync->add_timestamp(update);
+  }
+  JsonArray values = update["values"].to<JsonArray>();
+  for (int kind = 0; kind < kNumAlarms; kind++) {
+    if (dirty_[kind].none()) {
+      continue;
+    }
+    for (int i = 0; i < kMaxChannels; i++) {
+      if (!dirty_[kind][i] || !registered_[i]) {
+        continue;
+      }
+      bool active = active_[kind][i];
+      JsonObject entry = values.add<JsonObject>();
+      entry["path"] = String("notifications.") +
+                      put_requests_[i]->get_sk_path() + "." + kAlarmNames[kind];
+      JsonObject value = entry["value"].to<JsonObject>();
+      value["state"] = active ? "alert" : "normal";
+      JsonArray method = value["method"].to<JsonArray>();
+      if (active) {
+        method.add("visual");
+        method.add("sound");
+      }
+      value["message"] = kAlarmMessages[kind];
+    }
+    dirty_[kind].reset();
+  }
+  any_dirty_ = false;
+
+  if (values.size() == 0) {
+    return;
+  }
+  String output;
+  serializeJson(delta, output);
+  ws_client->sendTXT(output);
+  debugD("Published %d channel notification(s)", (int)values.size());
+}
@@ -0,0 +1,80 @@
+// Channel fault tracking and SignalK notifications
+//
+// ChannelAlarms watches the command/readback cycle of every relay channel and
+// raises notifications under notifications.<relay path>.<alarm> when a
+// command is not confirmed within the timeout, when the listener value
+// diverges from the last command, or when a button is held down for too
+// long. Commands, their timestamps and confirmations are read from the
+// channel store; the alarms only keep the button timers and one bitset per
+// alarm kind. All changes made during one event loop tick are published
+// together as a single delta.
+//
+// A readback mismatch is only raised within a settle window after the
+// command, e.g. when the relay drops out again. Later changes come from
+// other panels, the server, leases or schedules elsewhere and become the new
+// baseline.
+
+#ifndef CHANNEL_ALARMS_H_
+#define CHANNEL_ALARMS_H_
+
+#include <Arduino.h>
+
+#include <bitset>
+#include <cstdint>
+
+#include "channel_config.h"
+#include "channel_store.h"
+#include "sensesp/signalk/signalk_put_request.h"
+
+enum class ChannelAlarm : uint8_t {
+  kCommandTimeout = 0,
+  kReadbackMismatch,
+  kStuckButton,
+  kCount
+};
+
+class ChannelAlarms {
+ public:
+  static constexpr int kNumAlarms = static_cast<int>(ChannelAlarm::kCount);
+
+  ChannelAlarms(ChannelStore* store, unsigned int command_timeout_ms = 5000,
+                unsigned int stuck_button_ms = 10000,
+                unsigned int settle_window_ms = 10000);
+
+  // Register a channel. The notification path is derived from the PUT
+  // request's current SignalK path.
+  void add_channel(int channel, sensesp::SKPutRequest<bool>* put_request);
+
+  // The SignalK server reported a new value for the channel. Call after the
+  // store has recorded it.
+  void state_received(int channel, bool state);
+  // The debounced button of the channel changed state.
+  void button_changed(int channel, bool pressed);
+
+  bool is_active(ChannelAlarm alarm, int channel) const {
+    return active_[static_cast<int>(alarm)][channel];
+  }
+
+ private:
+  void set_alarm(ChannelAlarm alarm, int channel, bool active);
+  void check_timers();
+  void flush();
+
+  ChannelStore* store_;
+  const unsigned int command_timeout_ms_;
+  const unsigned int stuck_button_ms_;
+  const unsigned int settle_window_ms_;
+
+  sensesp::SKPutRequest<bool>* put_requests_[kMaxChannels] = {};
+  uint32_t button_down_since_[kMaxChannels] = {};
+
+  std::bitset<kMaxChannels> registered_;
+  std::bitset<kMaxChannels> button_down_;
+
+  std::bitset<kMaxChannels> active_[kNumAlarms];
+  std::bitset<kMaxChannels> dirty_[kNumAlarms];
+  bool any_dirty_ = false;
+  bool was_connected_ = false;
+};
+
+#endif  // CHANNEL_ALARMS_H_
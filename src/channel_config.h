@@ -0,0 +1,80 @@
+// Relay channel table types
+//
+// Every relay channel is described by one ChannelConfig entry. The priority
+// class decides the order in which a channel's commands are transmitted and
+// its incoming state updates are processed, and how quickly an unconfirmed
+// command is retried.
+//
+// A remote channel commands a relay elsewhere through PUTs to the SignalK
+// server. An actuator channel drives a relay output on this device and
+// handles PUTs for its own path. A Modbus channel switches a coil of a
+// Modbus relay board.
+//
+// Dimmers are listed separately in DimmerConfig entries; see dimmer_bank.h.
+// Display-only mirrors of paths controlled elsewhere are listed in
+// MirrorConfig entries; see mirror_bank.h.
+
+#ifndef CHANNEL_CONFIG_H_
+#define CHANNEL_CONFIG_H_
+
+#include <bitset>
+#include <cstdint>
+
+// Upper bound on the number of channels; sizes all per-channel tables.
+constexpr int kMaxChannels = 32;
+
+using ChannelSet = std::bitset<kMaxChannels>;
+
+enum class ChannelPriority : uint8_t {
+  kCritical = 0,  // navigation lights, bilge pumps
+  kNormal,
+  kLow,  // comfort and mood lighting
+  kCount
+};
+
+constexpr int kNumPriorities = static_cast<int>(ChannelPriority::kCount);
+
+constexpr const char* kPriorityNames[kNumPriorities] = {"critical", "normal",
+                                                        "low"};
+
+// Time to wait for the listener to confirm a command before retrying it.
+constexpr unsigned int kAckTimeoutMs[kNumPriorities] = {500, 2000, 4000};
+
+enum class ChannelRole : uint8_t { kRemote = 0, kActuator, kModbus };
+
+struct ChannelConfig {
+  int button_pin;
+  int led_pin;
+  const char* sk_path;
+  ChannelPriority priority;
+  // Switched off by the server plugin when the lease is not renewed.
+  bool leased;
+  ChannelRole role = ChannelRole::kRemote;
+  // Relay output of actuator channels.
+  int relay_pin = -1;
+  // Coil address of Modbus channels.
+  int coil = -1;
+};
+
+struct DimmerConfig {
+  // dimmingLevel path, e.g. "electrical.switches.light.saloon.dimmingLevel".
+  const char* sk_path;
+  // PWM output of a dimmer on this device, or -1 for a dimmer elsewhere.
+  int pwm_pin = -1;
+};
+
+struct MirrorConfig {
+  const char* sk_path;
+  // Indicator output, or -1 if the path only feeds groups.
+  int8_t led_pin = -1;
+  // Bit mask of the MirrorGroupConfig entries this path belongs to.
+  uint8_t groups = 0;
+};
+
+// Aggregate indicator, lit while any path of the group is on.
+struct MirrorGroupConfig {
+  const char* name;
+  int8_t led_pin;
+};
+
+#endif  // CHANNEL_CONFIG_H_
@@ -0,0 +1,123 @@
+#include "channel_meta.h"
+
+#include <ArduinoJson.h>
+
+#include "sensesp.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+ChannelMetaPublisher::ChannelMetaPublisher(
+    unsigned int config_check_interval_ms) {
+  event_loop()->onTick([this]() { check_connection(); });
+  event_loop()->onRepeat(config_check_interval_ms,
+                         [this]() { check_config(); });
+}
+
+void ChannelMetaPublisher::add_channel(int channel,
+                                       SKPutRequest<bool>* put_request,
+                                       const String& description,
+                                       const String& display_name,
+                                       const char* units) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds metadata table size", channel);
+    return;
+  }
+  meta_[channel].put_request = put_request;
+  meta_[channel].description = description;
+  meta_[channel].display_name = display_name;
+  meta_[channel].units = units;
+  registered_.set(channel);
+  cached_delta_ = "";
+}
+
+void ChannelMetaPublisher::add_channel(int channel, const char* sk_path,
+                                       const String& description,
+                                       const String& display_name,
+                                       const char* units) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds metadata table size", channel);
+    return;
+  }
+  meta_[channel].fixed_path = sk_path;
+  meta_[channel].description = description;
+  meta_[channel].display_name = display_name;
+  meta_[channel].units = units;
+  registered_.set(channel);
+  cached_delta_ = "";
+}
+
+String ChannelMetaPublisher::current_path(int channel) const {
+  const Meta& meta = meta_[channel];
+  if (meta.put_request != nullptr) {
+    return meta.put_request->get_sk_path();
+  }
+  return meta.fixed_path;
+}
+
+String ChannelMetaPublisher::build_delta(const ChannelSet& channels) const {
+  JsonDocument delta;
+  JsonArray meta_array = delta["updates"][0]["meta"].to<JsonArray>();
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!channels[i]) {
+      continue;
+    }
+    const Meta& meta = meta_[i];
+    JsonObject entry = meta_array.add<JsonObject>();
+    entry["path"] = meta.published_path;
+    JsonObject value = entry["value"].to<JsonObject>();
+    value["description"] = meta.description;
+    value["displayName"] = meta.display_name;
+    if (meta.units != nullptr) {
+      value["units"] = meta.units;
+    }
+  }
+  String output;
+  serializeJson(delta, output);
+  return output;
+}
+
+void ChannelMetaPublisher::check_connection() {
+  auto ws_client = sensesp_app->get_ws_client();
+  bool connected = ws_client->is_connected();
+  if (connected == was_connected_) {
+    return;
+  }
+  was_connected_ = connected;
+  if (!connected || registered_.none()) {
+    return;
+  }
+  if (cached_delta_.length() == 0) {
+    for (int i = 0; i < kMaxChannels; i++) {
+      if (registered_[i]) {
+        meta_[i].published_path = current_path(i);
+      }
+    }
+    cached_delta_ = build_delta(registered_);
+  }
+  ws_client->sendTXT(cached_delta_);
+  debugD("Published metadata for %d channel(s)", (int)registered_.count());
+}
+
+void ChannelMetaPublisher::check_config() {
+  if (!was_connected_ || cached_delta_.length() == 0) {
+    return;
+  }
+  ChannelSet changed;
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!registered_[i] || meta_[i].put_request == nullptr) {
+      continue;
+    }
+    String path = current_path(i);
+    if (path != meta_[i].published_path) {
+      meta_[i].published_path = path;
+      changed.set(i);
+    }
+  }
+  if (changed.none()) {
+    return;
+  }
+  String delta = build_delta(changed);
+  sensesp_app->get_ws_client()->sendTXT(delta);
+  cached_delta_ = build_delta(registered_);
+}
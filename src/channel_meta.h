@@ -0,0 +1,50 @@
+// SignalK metadata for relay channels
+//
+// ChannelMetaPublisher sends the description, display name and units of all
+// channel paths as one combined meta delta each time the websocket
+// connection comes up. The serialized delta is cached, so reconnects only
+// resend it. When a channel's SignalK path is reconfigured, a meta delta for
+// just the changed channels is sent and the cached delta is rebuilt.
+
+#ifndef CHANNEL_META_H_
+#define CHANNEL_META_H_
+
+#include <Arduino.h>
+
+#include "channel_config.h"
+#include "sensesp/signalk/signalk_put_request.h"
+
+class ChannelMetaPublisher {
+ public:
+  ChannelMetaPublisher(unsigned int config_check_interval_ms = 5000);
+
+  // Channel whose path is configurable through its PUT request.
+  void add_channel(int channel, sensesp::SKPutRequest<bool>* put_request,
+                   const String& description, const String& display_name,
+                   const char* units = nullptr);
+  // Channel with a fixed path.
+  void add_channel(int channel, const char* sk_path, const String& description,
+                   const String& display_name, const char* units = nullptr);
+
+ private:
+  struct Meta {
+    sensesp::SKPutRequest<bool>* put_request = nullptr;
+    const char* fixed_path = nullptr;
+    String published_path;
+    String description;
+    String display_name;
+    const char* units = nullptr;
+  };
+
+  String current_path(int channel) const;
+  String build_delta(const ChannelSet& channels) const;
+  void check_connection();
+  void check_config();
+
+  Meta meta_[kMaxChannels];
+  ChannelSet registered_;
+  String cached_delta_;
+  bool was_connected_ = false;
+};
+
+#endif  // CHANNEL_META_H_
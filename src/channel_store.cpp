@@ -0,0 +1,110 @@
+#include "channel_store.h"
+
+#include <cstring>
+
+#include "sensesp.h"
+
+void ChannelStore::add_channel(int channel) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds channel store size", channel);
+    return;
+  }
+  registered_.set(channel);
+}
+
+void ChannelStore::command(int channel, bool state) {
+  if (!registered_[channel]) {
+    return;
+  }
+  commanded_[channel] = state;
+  commanded_at_[channel] = millis();
+  pending_.set(channel);
+}
+
+int32_t ChannelStore::confirm(int channel, bool state) {
+  if (!registered_[channel]) {
+    return -1;
+  }
+  uint32_t now = millis();
+  if (!known_[channel] || state_[channel] != state) {
+    known_.set(channel);
+    state_[channel] = state;
+    versions_[channel] = ++version_;
+    changed_at_[channel] = now;
+  }
+  if (!pending_[channel] || commanded_[channel] != state) {
+    return -1;
+  }
+  pending_.reset(channel);
+  uint32_t latency_ms = now - commanded_at_[channel];
+  latency_sum_ms_[channel] += latency_ms;
+  if (latency_ms > latency_max_ms_[channel]) {
+    latency_max_ms_[channel] = latency_ms;
+  }
+  if (latency_count_[channel] < UINT16_MAX) {
+    latency_count_[channel]++;
+  }
+  return latency_ms;
+}
+
+void ChannelStore::replicate(const ChannelSet& commanded,
+                             const ChannelSet& pending) {
+  ChannelSet next_commanded = commanded & registered_;
+  ChannelSet next_pending = pending & registered_;
+  // The peer does not send command times; time new commands from now so
+  // that timeouts and latencies do not count from an old local command.
+  ChannelSet issued =
+      next_pending & (~pending_ | (next_commanded ^ commanded_));
+  if (issued.any()) {
+    uint32_t now = millis();
+    for (int i = 0; i < kMaxChannels; i++) {
+      if (issued[i]) {
+        commanded_at_[i] = now;
+      }
+    }
+  }
+  commanded_ = next_commanded;
+  pending_ = next_pending;
+}
+
+ChannelSet ChannelStore::scan_pending(uint32_t age_ms, uint32_t now) const {
+  ChannelSet result;
+  if (pending_.none()) {
+    return result;
+  }
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (pending_[i] && now - commanded_at_[i] >= age_ms) {
+      result.set(i);
+    }
+  }
+  return result;
+}
+
+ChannelSet ChannelStore::changed_since(uint32_t version) const {
+  ChannelSet result;
+  if (version >= version_) {
+    return result;
+  }
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (versions_[i] > version) {
+      result.set(i);
+    }
+  }
+  return result;
+}
+
+void ChannelStore::snapshot(Snapshot* out) const {
+  out->version = version_;
+  out->registered = registered_;
+  out->known = known_;
+  out->state = state_;
+  out->commanded = commanded_;
+  out->pending = pending_;
+  memcpy(out->versions, versions_, sizeof(versions_));
+}
+
+void ChannelStore::reset_latency() {
+  memset(latency_sum_ms_, 0, sizeof(latency_sum_ms_));
+  memset(latency_max_ms_, 0, sizeof(latency_max_ms_));
+  memset(latency_count_, 0, sizeof(latency_count_));
+}
@@ -0,0 +1,99 @@
+// Central per-channel state store
+//
+// ChannelStore holds the state every module needs about a relay channel in
+// parallel arrays indexed by channel number: packed bits for the confirmed
+// and commanded states and for pending commands, plus per-channel versions,
+// timestamps and confirmation latency accumulators. Sweeps over all
+// channels are bit operations or walks over one small array, with no
+// pointer chasing.
+//
+// The commanded state is recorded when a command is issued. The confirmed
+// state is recorded when the server, an actuator or the Modbus board
+// reports it. A command is pending from when it is issued until the
+// matching state is confirmed. Every change of a confirmed state bumps a
+// global version and stamps the channel with it, so the channels changed
+// since any earlier version can be found without a change log.
+//
+// The store lives in the event loop; other tasks work on a snapshot.
+
+#ifndef CHANNEL_STORE_H_
+#define CHANNEL_STORE_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "channel_config.h"
+
+class ChannelStore {
+ public:
+  struct Snapshot {
+    uint32_t version = 0;
+    ChannelSet registered;
+    ChannelSet known;
+    ChannelSet state;
+    ChannelSet commanded;
+    ChannelSet pending;
+    uint32_t versions[kMaxChannels] = {};
+  };
+
+  void add_channel(int channel);
+
+  // A command was issued for the channel.
+  void command(int channel, bool state);
+  // The channel's state was reported. Returns the confirmation latency in
+  // milliseconds if this confirms the pending command, or -1.
+  int32_t confirm(int channel, bool state);
+  // Take over commanded and pending bits replicated from a peer. Commands
+  // that are new to this store count as issued now.
+  void replicate(const ChannelSet& commanded, const ChannelSet& pending);
+
+  bool state(int channel) const { return state_[channel]; }
+  bool commanded(int channel) const { return commanded_[channel]; }
+  bool known(int channel) const { return known_[channel]; }
+  uint32_t version() const { return version_; }
+  uint32_t changed_at(int channel) const { return changed_at_[channel]; }
+  uint32_t commanded_at(int channel) const { return commanded_at_[channel]; }
+
+  const ChannelSet& registered() const { return registered_; }
+  const ChannelSet& states() const { return state_; }
+  const ChannelSet& commanded_states() const { return commanded_; }
+  const ChannelSet& pending() const { return pending_; }
+  // Pending commands issued at least age_ms ago.
+  ChannelSet scan_pending(uint32_t age_ms, uint32_t now) const;
+  // Channels whose confirmed state changed after the given version.
+  ChannelSet changed_since(uint32_t version) const;
+  // Pending channels whose confirmed state already matches the command.
+  ChannelSet settled() const {
+    return pending_ & known_ & ~(state_ ^ commanded_);
+  }
+  void snapshot(Snapshot* out) const;
+
+  // Confirmation latency since the last reset_latency().
+  uint32_t latency_count(int channel) const { return latency_count_[channel]; }
+  uint32_t latency_sum_ms(int channel) const {
+    return latency_sum_ms_[channel];
+  }
+  uint32_t latency_max_ms(int channel) const {
+    return latency_max_ms_[channel];
+  }
+  void reset_latency();
+
+ private:
+  ChannelSet registered_;
+  ChannelSet known_;
+  ChannelSet state_;
+  ChannelSet commanded_;
+  ChannelSet pending_;
+
+  uint32_t version_ = 0;
+  uint32_t versions_[kMaxChannels] = {};
+  uint32_t changed_at_[kMaxChannels] = {};
+  uint32_t commanded_at_[kMaxChannels] = {};
+
+  uint32_t latency_sum_ms_[kMaxChannels] = {};
+  uint32_t latency_max_ms_[kMaxChannels] = {};
+  uint16_t latency_count_[kMaxChannels] = {};
+};
+
+#endif  // CHANNEL_STORE_H_
@@ -0,0 +1,113 @@
+#include "clock_sync.h"
+
+#include <time.h>
+
+#include <cstdlib>
+
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_put_request.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+ClockSync* clock_sync = nullptr;
+
+ClockSync::ClockSync(unsigned int interval_ms) {
+  event_loop()->onRepeat(interval_ms, [this]() { send_request(); });
+}
+
+int64_t ClockSync::server_time_ms() const {
+  return to_server_time_ms(local_ms());
+}
+
+String ClockSync::format_timestamp(int64_t time_ms) {
+  time_t seconds = time_ms / 1000;
+  struct tm utc;
+  gmtime_r(&seconds, &utc);
+  char buf[32];
+  size_t len = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+  snprintf(buf + len, sizeof(buf) - len, ".%03dZ",
+           static_cast<int>(time_ms % 1000));
+  return buf;
+}
+
+void ClockSync::add_timestamp(JsonObject obj) const {
+  if (is_synced()) {
+    obj["timestamp"] = format_timestamp(server_time_ms());
+  }
+}
+
+void ClockSync::add_sample(int64_t local_send_ms, int64_t server_ms,
+                           int64_t local_receive_ms) {
+  uint32_t delay_ms = local_receive_ms - local_send_ms;
+  // The server is assumed to have answered halfway through the round trip.
+  int64_t midpoint = local_send_ms + delay_ms / 2;
+  samples_[next_sample_] = {server_ms - midpoint, delay_ms};
+  next_sample_ = (next_sample_ + 1) % kNumSamples;
+  if (num_samples_ < kNumSamples) {
+    num_samples_++;
+  }
+
+  // Use the sample with the shortest round trip; it is least affected by
+  // queuing delays.
+  const Sample* best = &samples_[0];
+  for (int i = 1; i < num_samples_; i++) {
+    if (samples_[i].delay_ms < best->delay_ms) {
+      best = &samples_[i];
+    }
+  }
+  offset_ms_ = best->offset_ms;
+  uncertainty_ms_ = (best->delay_ms + 1) / 2;
+
+  offset_s_.set(offset_ms_ / 1000.0);
+  uncertainty_s_.set(uncertainty_ms_ / 1000.0);
+}
+
+void ClockSync::send_request() {
+  if (!sensesp_app->get_ws_client()->is_connected()) {
+    return;
+  }
+  if (awaiting_response_ && link_quality_ != nullptr) {
+    // The previous request was never answered.
+    link_quality_->add_delivery(false);
+  }
+  awaiting_response_ = true;
+  int64_t sent_at = local_ms();
+  JsonDocument request;
+  request["context"] = "vessels.self";
+  JsonObject put = request["put"].to<JsonObject>();
+  put["path"] = "remoteRelay.clock";
+  put["value"] = sent_at;
+
+  SKRequest::send_request(
+      request,
+      [this, sent_at](JsonDocument& response) {
+        int64_t received_at = local_ms();
+        if (response["state"].as<String>() != "COMPLETED") {
+          return;
+        }
+        awaiting_response_ = false;
+        if (link_quality_ != nullptr) {
+          link_quality_->add_delivery(true);
+          link_quality_->add_rtt_sample(received_at - sent_at);
+        }
+        if (response["statusCode"].as<int>() != 200) {
+          if (!plugin_missing_logged_) {
+            debugW("Clock sync unavailable, is the server plugin enabled?");
+            plugin_missing_logged_ = true;
+          }
+          return;
+        }
+        if (!response["message"].is<const char*>()) {
+          // Answered by something other than the plugin's clock handler.
+          return;
+        }
+        int64_t server_ms =
+            strtoll(response["message"].as<const char*>(), nullptr, 10);
+        if (server_ms <= 0) {
+          return;
+        }
+        add_sample(sent_at, server_ms, received_at);
+      },
+      5000);
+}
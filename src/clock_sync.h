@@ -0,0 +1,90 @@
+// Clock offset estimation against the SignalK server
+//
+// ClockSync periodically sends a PUT to remoteRelay.clock, which the
+// companion server plugin answers with the server's wall clock time. Each
+// round trip gives an NTP-style offset sample; the sample with the shortest
+// round trip out of the last few is used, and half its round trip is the
+// uncertainty. Commands and published deltas use the corrected time as
+// their timestamp. The offset and its uncertainty are published as
+// diagnostics.
+//
+// Local times come from the 64-bit microsecond timer rather than millis(),
+// which wraps after 49.7 days and would corrupt the samples around the
+// wrap.
+
+#ifndef CLOCK_SYNC_H_
+#define CLOCK_SYNC_H_
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+
+#include <cstdint>
+
+#include "link_quality.h"
+#include "sensesp/system/observablevalue.h"
+
+class ClockSync {
+ public:
+  static constexpr int kNumSamples = 8;
+
+  ClockSync(unsigned int interval_ms = 30000);
+
+  bool is_synced() const { return num_samples_ > 0; }
+
+  // Local monotonic time in milliseconds since boot; never wraps.
+  static int64_t local_ms() { return esp_timer_get_time() / 1000; }
+
+  // Server wall clock time in milliseconds since the epoch.
+  int64_t server_time_ms() const;
+  int64_t to_server_time_ms(int64_t local_ms) const {
+    return offset_ms_ + local_ms;
+  }
+  int64_t offset_ms() const { return offset_ms_; }
+  uint32_t uncertainty_ms() const { return uncertainty_ms_; }
+
+  // Format server time as an ISO 8601 timestamp as used by SignalK.
+  static String format_timestamp(int64_t time_ms);
+
+  // Set obj["timestamp"] to the current server time if the clock is synced.
+  void add_timestamp(JsonObject obj) const;
+
+  // Feed one round trip. All times in milliseconds; local times are
+  // local_ms().
+  void add_sample(int64_t local_send_ms, int64_t server_ms,
+                  int64_t local_receive_ms);
+
+  // Report round trips and unanswered requests to the link estimate.
+  void set_link_quality(LinkQuality* link_quality) {
+    link_quality_ = link_quality;
+  }
+
+  // Diagnostics in seconds, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& offset_s() { return offset_s_; }
+  sensesp::ObservableValue<float>& uncertainty_s() { return uncertainty_s_; }
+
+ private:
+  void send_request();
+
+  struct Sample {
+    int64_t offset_ms;
+    uint32_t delay_ms;
+  };
+
+  Sample samples_[kNumSamples] = {};
+  int num_samples_ = 0;
+  int next_sample_ = 0;
+  int64_t offset_ms_ = 0;
+  uint32_t uncertainty_ms_ = 0;
+  bool plugin_missing_logged_ = false;
+  bool awaiting_response_ = false;
+  LinkQuality* link_quality_ = nullptr;
+
+  sensesp::ObservableValue<float> offset_s_;
+  sensesp::ObservableValue<float> uncertainty_s_;
+};
+
+// Set up in setup(); nullptr until then.
+extern ClockSync* clock_sync;
+
+#endif  // CLOCK_SYNC_H_
@@ -0,0 +1,161 @@
+#include "compact_commands.h"
+
+#include <ArduinoJson.h>
+
+#include "clock_sync.h"
+#include "sensesp.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr int kProtocolVersion = 1;
+
+}  // namespace
+
+CompactCommands::CompactCommands(unsigned int config_check_interval_ms) {
+  event_loop()->onTick([this]() { check_connection(); });
+  event_loop()->onRepeat(config_check_interval_ms,
+                         [this]() { check_config(); });
+}
+
+void CompactCommands::add_channel(int channel,
+                                  SKPutRequest<bool>* put_request) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds compact command table size", channel);
+    return;
+  }
+  put_requests_[channel] = put_request;
+  registered_.set(channel);
+}
+
+void CompactCommands::check_connection() {
+  bool connected = sensesp_app->get_ws_client()->is_connected();
+  if (connected == was_connected_) {
+    return;
+  }
+  was_connected_ = connected;
+  active_ = false;
+  session_++;
+  if (connected && registered_.any()) {
+    send_hello();
+  }
+}
+
+void CompactCommands::check_config() {
+  if (!was_connected_ || registered_.none() ||
+      paths_hash() == sent_paths_hash_) {
+    return;
+  }
+  debugI("Relay paths changed; sending compact command table again");
+  active_ = false;
+  session_++;
+  send_hello();
+}
+
+uint32_t CompactCommands::paths_hash() const {
+  // FNV-1a over the paths, with the channel number as separator.
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!registered_[i]) {
+      continue;
+    }
+    hash = (hash ^ i) * 16777619u;
+    String path = put_requests_[i]->get_sk_path();
+    for (size_t j = 0; j < path.length(); j++) {
+      hash = (hash ^ static_cast<uint8_t>(path[j])) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+void CompactCommands::send_hello() {
+  sent_paths_hash_ = paths_hash();
+  JsonDocument request;
+  request["context"] = "vessels.self";
+  JsonObject put = request["put"].to<JsonObject>();
+  put["path"] = "remoteRelay.hello";
+  JsonObject value = put["value"].to<JsonObject>();
+  value["version"] = kProtocolVersion;
+  value["id"] = SensESPBaseApp::get_hostname();
+  // Path indices are channel numbers; unused channels are null.
+  JsonArray paths = value["paths"].to<JsonArray>();
+  int num_paths = 0;
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (registered_[i]) {
+      num_paths = i + 1;
+    }
+  }
+  for (int i = 0; i < num_paths; i++) {
+    if (registered_[i]) {
+      paths.add(put_requests_[i]->get_sk_path());
+    } else {
+      paths.add(nullptr);
+    }
+  }
+
+  uint32_t session = session_;
+  SKRequest::send_request(
+      request,
+      [this, session](JsonDocument& response) {
+        if (session != session_ ||
+            response["state"].as<String>() != "COMPLETED") {
+          return;
+        }
+        active_ = response["statusCode"].as<int>() == 200;
+        debugI("Compact relay commands %s",
+               active_ ? "enabled" : "not supported by the server");
+      },
+      5000);
+}
+
+void CompactCommands::fall_back() {
+  if (!active_) {
+    return;
+  }
+  active_ = false;
+  // Late hello responses must not turn it back on.
+  session_++;
+  debugW("Compact relay commands disabled until the next connection");
+}
+
+void CompactCommands::add(int channel, bool state) {
+  batch_.set(channel);
+  batch_value_[channel] = state;
+}
+
+void CompactCommands::flush() {
+  if (batch_.none()) {
+    return;
+  }
+  if (batch_.count() == 1) {
+    // With its id and envelope, a compact PUT of one command is no smaller
+    // than the plain PUT.
+    for (int i = 0; i < kMaxChannels; i++) {
+      if (batch_[i]) {
+        put_requests_[i]->set(batch_value_[i]);
+      }
+    }
+    batch_.reset();
+    return;
+  }
+  JsonDocument request;
+  request["context"] = "vessels.self";
+  JsonObject put = request["put"].to<JsonObject>();
+  put["path"] = "remoteRelay.command";
+  if (clock_sync != nullptr) {
+    clock_sync->add_timestamp(put);
+  }
+  JsonObject value = put["value"].to<JsonObject>();
+  value["id"] = SensESPBaseApp::get_hostname();
+  JsonArray commands = value["c"].to<JsonArray>();
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (batch_[i]) {
+      commands.add(i * 2 + (batch_value_[i] ? 1 : 0));
+    }
+  }
+  batch_.reset();
+  // Confirmation comes from the value listeners, as with regular PUTs.
+  SKRequest::send_request(request, [](JsonDocument&) {});
+}
@@ -0,0 +1,59 @@
+// Compact relay command encoding negotiated with the server plugin
+//
+// On every connect, CompactCommands sends the table of channel paths to the
+// companion server plugin with a PUT to remoteRelay.hello. If the plugin
+// accepts it, relay commands are no longer sent as one JSON PUT per channel:
+// all commands of a tick go out as a single PUT to remoteRelay.command whose
+// value is an array of integers, channel * 2 + state, indexing the interned
+// path table. The plugin expands them into PUTs on the real paths. A tick
+// with a single command sends it as a plain PUT, which is no larger. Without
+// the plugin, the regular per-channel JSON PUTs are used.
+//
+// When a channel's path is changed through its config item, the plugin's
+// table is out of date. The paths are checked periodically; on a change the
+// hello is sent again, and plain PUTs are used until it is accepted.
+
+#ifndef COMPACT_COMMANDS_H_
+#define COMPACT_COMMANDS_H_
+
+#include <Arduino.h>
+
+#include "channel_config.h"
+#include "sensesp/signalk/signalk_put_request.h"
+
+class CompactCommands {
+ public:
+  CompactCommands(unsigned int config_check_interval_ms = 5000);
+
+  void add_channel(int channel, sensesp::SKPutRequest<bool>* put_request);
+
+  // True once the plugin has accepted the path table on this connection.
+  bool active() const { return active_; }
+
+  // Send plain PUTs for the rest of this connection.
+  void fall_back();
+
+  // Add a command to the batch sent by flush().
+  void add(int channel, bool state);
+  void flush();
+
+ private:
+  void check_connection();
+  void check_config();
+  void send_hello();
+  // Hash of the current path table.
+  uint32_t paths_hash() const;
+
+  sensesp::SKPutRequest<bool>* put_requests_[kMaxChannels] = {};
+  ChannelSet registered_;
+  ChannelSet batch_;
+  ChannelSet batch_value_;
+  bool was_connected_ = false;
+  bool active_ = false;
+  // Incremented on every connect and path change so stale hello responses
+  // are ignored.
+  uint32_t session_ = 0;
+  uint32_t sent_paths_hash_ = 0;
+};
+
+#endif  // COMPACT_COMMANDS_H_
@@ -0,0 +1,34 @@
+#include "connection_monitor.h"
+
+#include "sensesp.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+ConnectionMonitor::ConnectionMonitor() {
+  sensesp_app->get_ws_client()->connect_to(
+      new LambdaConsumer<SKWSConnectionState>(
+          [this](SKWSConnectionState state) { state_changed(state); }));
+}
+
+void ConnectionMonitor::state_changed(SKWSConnectionState state) {
+  switch (state) {
+    case SKWSConnectionState::kSKWSConnected:
+      if (!connected_) {
+        connected_ = true;
+        connected_at_ = millis();
+      }
+      break;
+    case SKWSConnectionState::kSKWSDisconnected:
+      if (connected_) {
+        reconnects_++;
+        reconnect_count_.set(reconnects_);
+      }
+      connected_ = false;
+      break;
+    case SKWSConnectionState::kSKWSConnecting:
+    case SKWSConnectionState::kSKWSAuthorizing:
+      break;
+  }
+}
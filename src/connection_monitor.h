@@ -0,0 +1,40 @@
+// Websocket connection state
+//
+// ConnectionMonitor follows the SignalK websocket connection state for the
+// link quality estimate: whether the connection is up, since when, and how
+// often it was lost. The number of reconnects is published as a diagnostic.
+
+#ifndef CONNECTION_MONITOR_H_
+#define CONNECTION_MONITOR_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "sensesp/signalk/signalk_ws_client.h"
+#include "sensesp/system/observablevalue.h"
+
+class ConnectionMonitor {
+ public:
+  ConnectionMonitor();
+
+  bool connected() const { return connected_; }
+  uint32_t connected_since() const { return connected_at_; }
+  uint32_t reconnects() const { return reconnects_; }
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& reconnect_count() {
+    return reconnect_count_;
+  }
+
+ private:
+  void state_changed(sensesp::SKWSConnectionState state);
+
+  bool connected_ = false;
+  uint32_t connected_at_ = 0;
+  uint32_t reconnects_ = 0;
+
+  sensesp::ObservableValue<float> reconnect_count_;
+};
+
+#endif  // CONNECTION_MONITOR_H_
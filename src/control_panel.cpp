@@ -0,0 +1,242 @@
+#include "control_panel.h"
+
+#include <ArduinoJson.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "sensesp.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr int kMaxClients = 4;
+// Commands are a few digits; anything longer is not from the control page.
+constexpr size_t kMaxFrameLength = 8;
+
+struct Broadcast {
+  httpd_handle_t server;
+  char* payload;
+  size_t len;
+};
+
+// Decode the %XX escapes and '+' of a query value in place. False if an
+// escape is malformed.
+bool url_decode(char* value) {
+  char* out = value;
+  for (const char* in = value; *in != '\0'; in++) {
+    if (*in == '+') {
+      *out++ = ' ';
+    } else if (*in == '%') {
+      if (!isxdigit(static_cast<unsigned char>(in[1])) ||
+          !isxdigit(static_cast<unsigned char>(in[2]))) {
+        return false;
+      }
+      char hex[3] = {in[1], in[2], '\0'};
+      *out++ = static_cast<char>(strtol(hex, nullptr, 16));
+      in += 2;
+    } else {
+      *out++ = *in;
+    }
+  }
+  *out = '\0';
+  return true;
+}
+
+}  // namespace
+
+ControlPanel::ControlPanel(ChannelStore* store, const char* access_token,
+                           uint16_t port)
+    : store_(store) {
+#if CONFIG_HTTPD_WS_SUPPORT
+  size_t token_length = strlen(access_token);
+  if (token_length == 0) {
+    debugE("Control panel needs an access token; not started");
+    return;
+  }
+  if (token_length > kMaxTokenLength) {
+    debugE("Control panel token longer than %zu characters; not started",
+           kMaxTokenLength);
+    return;
+  }
+  memcpy(access_token_, access_token, token_length);
+  commands_ = xQueueCreate(16, sizeof(uint8_t));
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = port;
+  // The SensESP HTTP server already uses the default control port.
+  config.ctrl_port = 32768 + port;
+  config.max_open_sockets = kMaxClients;
+  config.lru_purge_enable = true;
+  if (httpd_start(&server_, &config) != ESP_OK) {
+    debugE("Control panel server failed to start on port %u", port);
+    server_ = nullptr;
+    return;
+  }
+
+  httpd_uri_t ws_uri = {};
+  ws_uri.uri = "/relays/ws";
+  ws_uri.method = HTTP_GET;
+  ws_uri.handler = handle_ws;
+  ws_uri.user_ctx = this;
+  ws_uri.is_websocket = true;
+  httpd_register_uri_handler(server_, &ws_uri);
+
+  event_loop()->onTick([this]() { tick(); });
+#else
+  debugE("Control panel needs CONFIG_HTTPD_WS_SUPPORT; not started");
+#endif
+}
+
+void ControlPanel::add_channel(int channel, const char* name,
+                               std::function<void(bool)> command) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds control panel size", channel);
+    return;
+  }
+  names_[channel] = name;
+  command_[channel] = command;
+  registered_.set(channel);
+  if (channel >= num_channels_) {
+    num_channels_ = channel + 1;
+  }
+}
+
+#if CONFIG_HTTPD_WS_SUPPORT
+
+bool ControlPanel::authorized(httpd_req_t* req) const {
+  // Room for a token with every character escaped.
+  char query[3 * kMaxTokenLength + 16];
+  char token[3 * kMaxTokenLength + 1] = {};
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+      httpd_query_key_value(query, "token", token, sizeof(token)) != ESP_OK ||
+      !url_decode(token) || strlen(token) > kMaxTokenLength) {
+    return false;
+  }
+  // Both buffers are zero-padded; compare all of them so the time taken
+  // does not depend on where they differ.
+  uint8_t diff = 0;
+  for (size_t i = 0; i <= kMaxTokenLength; i++) {
+    diff |= access_token_[i] ^ token[i];
+  }
+  return diff == 0;
+}
+
+esp_err_t ControlPanel::handle_ws(httpd_req_t* req) {
+  auto* self = static_cast<ControlPanel*>(req->user_ctx);
+  if (req->method == HTTP_GET) {
+    // Returning an error closes the socket right after the handshake.
+    if (!self->authorized(req)) {
+      debugW("Control panel client rejected: missing or wrong token");
+      return ESP_FAIL;
+    }
+    // Handshake done; the event loop sends the channel list.
+    self->client_joined_ = true;
+    return ESP_OK;
+  }
+
+  httpd_ws_frame_t frame = {};
+  esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+  if (err != ESP_OK) {
+    return err;
+  }
+  // The payload has to be read before the next frame can be parsed, so
+  // close the connection instead of buffering an oversized one.
+  if (frame.len > kMaxFrameLength) {
+    debugW("Control panel frame of %zu bytes; closing", frame.len);
+    return ESP_FAIL;
+  }
+  char buf[kMaxFrameLength + 1] = {};
+  if (frame.len > 0) {
+    frame.payload = reinterpret_cast<uint8_t*>(buf);
+    err = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (err != ESP_OK) {
+      return err;
+    }
+  }
+  if (frame.type != HTTPD_WS_TYPE_TEXT) {
+    return ESP_OK;
+  }
+  char* end;
+  long code = strtol(buf, &end, 10);
+  if (end == buf || code < 0 || code >= kMaxChannels * 2) {
+    return ESP_OK;
+  }
+  uint8_t command = code;
+  xQueueSend(self->commands_, &command, 0);
+  return ESP_OK;
+}
+
+void ControlPanel::send_to_clients(void* arg) {
+  auto* broadcast = static_cast<Broadcast*>(arg);
+  size_t num_fds = kMaxClients;
+  int fds[kMaxClients];
+  if (httpd_get_client_list(broadcast->server, &num_fds, fds) == ESP_OK) {
+    httpd_ws_frame_t frame = {};
+    frame.type = HTTPD_WS_TYPE_TEXT;
+    frame.payload = reinterpret_cast<uint8_t*>(broadcast->payload);
+    frame.len = broadcast->len;
+    for (size_t i = 0; i < num_fds; i++) {
+      if (httpd_ws_get_fd_info(broadcast->server, fds[i]) ==
+          HTTPD_WS_CLIENT_WEBSOCKET) {
+        httpd_ws_send_frame_async(broadcast->server, fds[i], &frame);
+      }
+    }
+  }
+  free(broadcast->payload);
+  delete broadcast;
+}
+
+String ControlPanel::build_message(bool with_names) const {
+  JsonDocument doc;
+  JsonArray states = doc["states"].to<JsonArray>();
+  JsonArray names;
+  if (with_names) {
+    names = doc["names"].to<JsonArray>();
+  }
+  for (int i = 0; i < num_channels_; i++) {
+    if (!registered_[i]) {
+      states.add(nullptr);
+      if (with_names) {
+        names.add(nullptr);
+      }
+      continue;
+    }
+    states.add(store_->state(i));
+    if (with_names) {
+      names.add(names_[i]);
+    }
+  }
+  String output;
+  serializeJson(doc, output);
+  return output;
+}
+
+void ControlPanel::tick() {
+  uint8_t code;
+  while (xQueueReceive(commands_, &code, 0) == pdTRUE) {
+    int channel = code >> 1;
+    if (registered_[channel]) {
+      command_[channel](code & 1);
+    }
+  }
+
+  bool joined = client_joined_.exchange(false);
+  uint32_t version = store_->version();
+  if (!joined && version == sent_version_) {
+    return;
+  }
+  sent_version_ = version;
+  // A new browser needs the channel names; everyone else just gets states.
+  String message = build_message(joined);
+  auto* broadcast = new Broadcast{server_, strdup(message.c_str()),
+                                  message.length()};
+  if (httpd_queue_work(server_, send_to_clients, broadcast) != ESP_OK) {
+    free(broadcast->payload);
+    delete broadcast;
+  }
+}
+
+#endif  // CONFIG_HTTPD_WS_SUPPORT
@@ -0,0 +1,73 @@
+// Virtual control panel websocket
+//
+// ControlPanel runs a small websocket server for the control page in web/.
+// Browsers send commands as text frames holding channel * 2 + state; they
+// are handed to the event loop through a queue and applied with the same
+// per-channel command functions the physical buttons use. Channel states
+// are read from the channel store and pushed to all connected browsers
+// whenever its version changes, batched per tick.
+//
+// The websocket server runs on its own port because the SensESP HTTP server
+// does not register websocket handlers. It runs in the HTTP server task, so
+// everything it touches crosses over to the event loop through the queue or
+// through httpd_queue_work().
+//
+// The websocket is outside the SensESP web UI and its login, so it needs an
+// access token of its own: browsers must connect with ?token=<token>, which
+// the control page forwards from its own URL. Without a token the panel is
+// not started, since anyone who could reach the port could switch every
+// channel, critical ones included. The token is compared in constant time.
+//
+// Needs CONFIG_HTTPD_WS_SUPPORT; sdkconfig.defaults enables it for the
+// ESP-IDF builds, and without it the panel is left out.
+
+#ifndef CONTROL_PANEL_H_
+#define CONTROL_PANEL_H_
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <atomic>
+#include <functional>
+
+#include "channel_config.h"
+#include "channel_store.h"
+
+class ControlPanel {
+ public:
+  static constexpr uint16_t kDefaultPort = 81;
+
+  static constexpr size_t kMaxTokenLength = 32;
+
+  ControlPanel(ChannelStore* store, const char* access_token,
+               uint16_t port = kDefaultPort);
+
+  void add_channel(int channel, const char* name,
+                   std::function<void(bool)> command);
+
+ private:
+  static esp_err_t handle_ws(httpd_req_t* req);
+  bool authorized(httpd_req_t* req) const;
+  static void send_to_clients(void* arg);
+
+  void tick();
+  String build_message(bool with_names) const;
+
+  ChannelStore* store_;
+  // Zero-padded, so comparisons always cover the whole buffer.
+  char access_token_[kMaxTokenLength + 1] = {};
+  httpd_handle_t server_ = nullptr;
+  QueueHandle_t commands_ = nullptr;
+  // Set by the server task when a browser connects.
+  std::atomic<bool> client_joined_{false};
+
+  String names_[kMaxChannels];
+  std::function<void(bool)> command_[kMaxChannels];
+  ChannelSet registered_;
+  uint32_t sent_version_ = 0;
+  int num_channels_ = 0;
+};
+
+#endif  // CONTROL_PANEL_H_
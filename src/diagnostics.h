@@ -0,0 +1,25 @@
+// Helpers for publishing controller diagnostics to SignalK
+
+#ifndef DIAGNOSTICS_H_
+#define DIAGNOSTICS_H_
+
+#include <Arduino.h>
+
+#include "sensesp/signalk/signalk_output.h"
+#include "sensesp_app.h"
+
+// SignalK path for a diagnostic value of this device.
+inline String diagnostic_path(const char* name) {
+  return String("sensorDevice.") + sensesp::SensESPBaseApp::get_hostname() +
+         "." + name;
+}
+
+// Publish a float diagnostic with the given SI units.
+template <typename P>
+inline void publish_diagnostic(P* producer, const char* name,
+                               const char* units) {
+  producer->connect_to(new sensesp::SKOutputFloat(
+      diagnostic_path(name), "", new sensesp::SKMetadata(units)));
+}
+
+#endif  // DIAGNOSTICS_H_
@@ -0,0 +1,156 @@
+#include "dimmer_bank.h"
+
+#include <ArduinoJson.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_put_request_listener.h"
+#include "sensesp/signalk/signalk_value_listener.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "timestamped_put_request.h"
+
+using namespace sensesp;
+
+namespace {
+
+// Handles PUTs of fade commands to a fade path.
+class FadePutListener : public SKPutListener {
+ public:
+  FadePutListener(const String& sk_path,
+                  std::function<void(float, uint32_t)> callback)
+      : SKPutListener(sk_path), callback_(callback) {}
+
+  void parse_value(const JsonObject& put) override {
+    JsonVariant value = put["value"];
+    // A missing or non-numeric target would read as 0 and switch the light
+    // off.
+    if (!value["target"].is<float>()) {
+      debugW("Ignoring fade on %s without a numeric target",
+             get_sk_path().c_str());
+      return;
+    }
+    float duration_s = value["duration"].as<float>();
+    callback_(value["target"].as<float>(),
+              duration_s > 0 ? duration_s * 1000 : 0);
+  }
+
+ private:
+  std::function<void(float, uint32_t)> callback_;
+};
+
+}  // namespace
+
+DimmerBank::DimmerBank() {
+  event_loop()->onRepeat(kLocalStepMs, [this]() { step(); });
+}
+
+String DimmerBank::fade_path(const String& level_path) {
+  int dot = -1;
+  for (int i = level_path.length() - 1; i >= 0; i--) {
+    if (level_path[i] == '.') {
+      dot = i;
+      break;
+    }
+  }
+  if (dot < 0) {
+    return level_path + ".fade";
+  }
+  return level_path.substring(0, dot) + ".fade";
+}
+
+void DimmerBank::add_dimmer(int dimmer, const DimmerConfig& config) {
+  if (dimmer < 0 || dimmer >= kMaxChannels) {
+    debugE("Dimmer %d exceeds dimmer bank size", dimmer);
+    return;
+  }
+  Dimmer& d = dimmers_[dimmer];
+  d.pwm_pin = config.pwm_pin;
+  d.fade_path = fade_path(config.sk_path);
+  registered_.set(dimmer);
+
+  auto on_fade = [this, dimmer](float target, uint32_t duration_ms) {
+    fade(dimmer, target, duration_ms);
+  };
+
+  if (config.pwm_pin >= 0) {
+    d.mode = Mode::kLocal;
+    pinMode(config.pwm_pin, OUTPUT);
+    analogWrite(config.pwm_pin, 0);
+    new FadePutListener(d.fade_path, on_fade);
+    auto* level_listener = new SKPutRequestListener<float>(config.sk_path);
+    level_listener->connect_to(new LambdaConsumer<float>(
+        [this, dimmer](float level) { fade(dimmer, level, 0); }));
+    d.level_output = new SKOutputFloat(config.sk_path);
+    d.level_output->set(0);
+    return;
+  }
+
+  // Stand in for the dimmer as the handler of its fade path.
+  d.mode = Mode::kRemoteInterpolated;
+  new FadePutListener(d.fade_path, on_fade);
+  d.level_request = new TimestampedPutRequest<float>(config.sk_path);
+  auto* listener = new SKValueListener<float>(config.sk_path);
+  listener->connect_to(new LambdaConsumer<float>([this, dimmer](float level) {
+    // While fading, reports trail the fade; go by the interpolation.
+    if (!fading_[dimmer]) {
+      dimmers_[dimmer].level = level;
+      dimmers_[dimmer].output = level;
+    }
+  }));
+}
+
+void DimmerBank::fade(int dimmer, float target, uint32_t duration_ms) {
+  if (dimmer < 0 || dimmer >= kMaxChannels || !registered_[dimmer]) {
+    return;
+  }
+  Dimmer& d = dimmers_[dimmer];
+  d.start_level = d.level;
+  d.target = std::min(std::max(target, 0.0f), 1.0f);
+  d.start_ms = millis();
+  d.duration_ms = duration_ms;
+  fading_.set(dimmer);
+}
+
+void DimmerBank::step() {
+  if (fading_.none()) {
+    return;
+  }
+  uint32_t now = millis();
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!fading_[i]) {
+      continue;
+    }
+    Dimmer& d = dimmers_[i];
+    uint32_t elapsed = now - d.start_ms;
+    bool done = elapsed >= d.duration_ms;
+    if (done) {
+      d.level = d.target;
+      fading_.reset(i);
+    } else {
+      d.level = d.start_level +
+                (d.target - d.start_level) * elapsed / d.duration_ms;
+    }
+
+    bool report_due = done || now - d.output_ms >= kRemoteStepMs;
+    switch (d.mode) {
+      case Mode::kLocal:
+        analogWrite(d.pwm_pin, lroundf(d.level * 255));
+        if (report_due) {
+          d.level_output->set(d.level);
+          d.output_ms = now;
+        }
+        break;
+      case Mode::kRemoteInterpolated:
+        if (report_due && (std::fabs(d.level - d.output) >= kMinRemoteStep ||
+                           (done && d.level != d.output))) {
+          d.level_request->set(d.level);
+          d.output = d.level;
+          d.output_ms = now;
+        }
+        break;
+    }
+  }
+}
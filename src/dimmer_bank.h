@@ -0,0 +1,78 @@
+// Dimmers with fade commands
+//
+// A fade command carries a target level (0 to 1) and a duration instead of
+// a stream of intermediate levels. It is sent as one PUT to the dimmer's
+// fade path, the sibling of its dimmingLevel path, with the value
+// {"target": 0.4, "duration": 1.5} (seconds).
+//
+// DimmerBank runs fades for dimmers that cannot run them themselves:
+//  - A dimmer on this device handles PUTs to its fade and dimmingLevel paths
+//    and interpolates its PWM output locally.
+//  - For a dimmer elsewhere, this device handles PUTs to the fade path and
+//    interpolates, sending dimmingLevel PUTs at a capped rate and skipping
+//    steps too small to see.
+// Dimmers elsewhere that run fades themselves handle their own fade path
+// and are not listed here.
+// A new command for a dimmer preempts its running fade; the new fade starts
+// from the level reached so far.
+
+#ifndef DIMMER_BANK_H_
+#define DIMMER_BANK_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "channel_config.h"
+#include "sensesp/signalk/signalk_output.h"
+#include "sensesp/signalk/signalk_put_request.h"
+
+class DimmerBank {
+ public:
+  // Output update interval of dimmers on this device.
+  static constexpr uint32_t kLocalStepMs = 20;
+  // Minimum interval between dimmingLevel PUTs to a dimmer elsewhere.
+  static constexpr uint32_t kRemoteStepMs = 200;
+  // Level changes below this are not sent to dimmers elsewhere.
+  static constexpr float kMinRemoteStep = 0.01;
+
+  DimmerBank();
+
+  void add_dimmer(int dimmer, const DimmerConfig& config);
+
+  // Fade to target over duration_ms, preempting any fade in progress. A
+  // zero duration sets the level at once.
+  void fade(int dimmer, float target, uint32_t duration_ms);
+
+  // The level reached, as far as this device knows.
+  float level(int dimmer) const { return dimmers_[dimmer].level; }
+
+  static String fade_path(const String& level_path);
+
+ private:
+  enum class Mode : uint8_t { kLocal, kRemoteInterpolated };
+
+  struct Dimmer {
+    Mode mode;
+    int pwm_pin;
+    float level = 0;
+    float start_level = 0;
+    float target = 0;
+    uint32_t start_ms = 0;
+    uint32_t duration_ms = 0;
+    // Level last written or sent.
+    float output = -1;
+    uint32_t output_ms = 0;
+    sensesp::SKOutputFloat* level_output = nullptr;
+    sensesp::SKPutRequest<float>* level_request = nullptr;
+    String fade_path;
+  };
+
+  void step();
+
+  Dimmer dimmers_[kMaxChannels];
+  ChannelSet registered_;
+  ChannelSet fading_;
+};
+
+#endif  // DIMMER_BANK_H_
@@ -0,0 +1,254 @@
+#include "latency_slo.h"
+
+#include <ArduinoJson.h>
+
+#include <cstring>
+
+#include "clock_sync.h"
+#include "diagnostics.h"
+#include "sensesp.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+namespace {
+
+const char* const kActionNames[] = {"none", "reconnect", "fallBack",
+                                    "notify"};
+
+}  // namespace
+
+LatencySlo::LatencySlo(ChannelStore* store, CompactCommands* compact,
+                       float quantile, uint32_t objective_ms,
+                       uint32_t window_ms, uint32_t min_samples)
+    : store_(store),
+      compact_(compact),
+      slice_ms_(window_ms / kNumSlices),
+      quantile_(quantile),
+      objective_ms_(objective_ms),
+      min_samples_(min_samples) {
+  event_loop()->onRepeat(slice_ms_, [this]() { rotate(); });
+  event_loop()->onTick([this]() { flush_notification(); });
+}
+
+int LatencySlo::bucket(uint32_t latency_ms) {
+  for (int b = 0; b < kNumBuckets - 1; b++) {
+    if (latency_ms <= kBucketMs[b]) {
+      return b;
+    }
+  }
+  return kNumBuckets - 1;
+}
+
+uint32_t LatencySlo::quantile_ms(const uint32_t* counts, float quantile) {
+  uint32_t total = 0;
+  for (int b = 0; b < kNumBuckets; b++) {
+    total += counts[b];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint32_t rank = quantile * total;
+  uint32_t seen = 0;
+  for (int b = 0; b < kNumBuckets - 1; b++) {
+    seen += counts[b];
+    if (seen > rank) {
+      return kBucketMs[b];
+    }
+  }
+  return kTimeoutMs;
+}
+
+void LatencySlo::confirmed(int channel, int32_t latency_ms) {
+  // Later confirmations were already counted as timeouts.
+  if (latency_ms >= 0 && static_cast<uint32_t>(latency_ms) <= kTimeoutMs) {
+    record(channel, latency_ms);
+  }
+}
+
+void LatencySlo::record(int channel, uint32_t latency_ms) {
+  uint16_t& count = channel_counts_[channel][bucket(latency_ms)];
+  if (count < UINT16_MAX) {
+    count++;
+  }
+}
+
+void LatencySlo::rotate() {
+  // Pending commands that passed the timeout during this slice.
+  uint32_t now = millis();
+  ChannelSet timed_out = store_->scan_pending(kTimeoutMs + 1, now) &
+                         ~store_->scan_pending(kTimeoutMs + 1 + slice_ms_, now);
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (timed_out[i]) {
+      record(i, kTimeoutMs + 1);
+    }
+  }
+
+  uint32_t slowest_mean_ms = 0;
+  slowest_channel_ = -1;
+  for (int i = 0; i < kMaxChannels; i++) {
+    uint32_t count = store_->latency_count(i);
+    if (count == 0) {
+      continue;
+    }
+    uint32_t mean_ms = store_->latency_sum_ms(i) / count;
+    if (mean_ms > slowest_mean_ms) {
+      slowest_mean_ms = mean_ms;
+      slowest_channel_ = i;
+    }
+  }
+  store_->reset_latency();
+
+  // Fold the channel histograms into the current slice.
+  uint32_t* slice = slice_counts_[slice_];
+  for (int i = 0; i < kMaxChannels; i++) {
+    for (int b = 0; b < kNumBuckets; b++) {
+      slice[b] += channel_counts_[i][b];
+      channel_counts_[i][b] = 0;
+    }
+  }
+
+  uint32_t window[kNumBuckets] = {};
+  uint32_t total = 0;
+  for (int s = 0; s < kNumSlices; s++) {
+    for (int b = 0; b < kNumBuckets; b++) {
+      window[b] += slice_counts_[s][b];
+      total += slice_counts_[s][b];
+    }
+  }
+  // The oldest slice makes room for the next one.
+  slice_ = (slice_ + 1) % kNumSlices;
+  memset(slice_counts_[slice_], 0, sizeof(slice_counts_[slice_]));
+
+  evaluate(window, total);
+}
+
+void LatencySlo::evaluate(const uint32_t* window, uint32_t total) {
+  uint32_t latency_ms = quantile_ms(window, quantile_);
+  quantile_latency_s_.set(latency_ms / 1000.0);
+  median_latency_s_.set(quantile_ms(window, 0.5) / 1000.0);
+
+  if (last_action_ != Action::kNone) {
+    slices_since_action_++;
+    if (slices_since_action_ < kNumSlices) {
+      // Give the last action a full window before judging it.
+      return;
+    }
+    if (slices_since_action_ == kNumSlices) {
+      publish_action(latency_ms);
+    }
+  }
+  if (total < min_samples_) {
+    return;
+  }
+
+  if (latency_ms <= objective_ms_) {
+    if (last_action_ != Action::kNone) {
+      debugI("Confirm latency back within objective: %u ms",
+             (unsigned)latency_ms);
+      last_action_ = Action::kNone;
+      escalation_.set(0);
+      if (notification_active_) {
+        notification_active_ = false;
+        notification_dirty_ = true;
+      }
+    }
+    return;
+  }
+
+  switch (last_action_) {
+    case Action::kNone:
+      take_action(Action::kReconnect, latency_ms);
+      break;
+    case Action::kReconnect:
+      if (compact_ != nullptr && compact_->active()) {
+        take_action(Action::kFallBack, latency_ms);
+      } else {
+        // Already on plain PUTs; nothing to switch.
+        take_action(Action::kNotify, latency_ms);
+      }
+      break;
+    case Action::kFallBack:
+      take_action(Action::kNotify, latency_ms);
+      break;
+    case Action::kNotify:
+      // Nothing left to try; the notification stays up.
+      break;
+  }
+}
+
+void LatencySlo::take_action(Action action, uint32_t latency_ms) {
+  debugW("Confirm latency %u ms misses the %u ms objective (slowest "
+         "channel %d); action: %s",
+         (unsigned)latency_ms, (unsigned)objective_ms_, slowest_channel_,
+         kActionNames[static_cast<int>(action)]);
+  last_action_ = action;
+  last_action_before_ms_ = latency_ms;
+  slices_since_action_ = 0;
+  escalation_.set(static_cast<int>(action));
+
+  switch (action) {
+    case Action::kReconnect:
+      sensesp_app->get_ws_client()->restart();
+      break;
+    case Action::kFallBack:
+      compact_->fall_back();
+      break;
+    case Action::kNotify:
+      notification_active_ = true;
+      notification_dirty_ = true;
+      break;
+    case Action::kNone:
+      break;
+  }
+}
+
+void LatencySlo::publish_action(uint32_t after_ms) {
+  const char* name = kActionNames[static_cast<int>(last_action_)];
+  debugI("Latency action %s: %u ms before, %u ms after", name,
+         (unsigned)last_action_before_ms_, (unsigned)after_ms);
+
+  JsonDocument delta;
+  JsonObject update = delta["updates"].add<JsonObject>();
+  if (clock_sync != nullptr) {
+    clock_sync->add_timestamp(update);
+  }
+  JsonObject entry = update["values"].add<JsonObject>();
+  entry["path"] = diagnostic_path("sloAction");
+  JsonObject value = entry["value"].to<JsonObject>();
+  value["action"] = name;
+  value["before"] = last_action_before_ms_ / 1000.0;
+  value["after"] = after_ms / 1000.0;
+  String output;
+  serializeJson(delta, output);
+  auto ws_client = sensesp_app->get_ws_client();
+  if (ws_client->is_connected()) {
+    ws_client->sendTXT(output);
+  }
+}
+
+void LatencySlo::flush_notification() {
+  if (!notification_dirty_ ||
+      !sensesp_app->get_ws_client()->is_connected()) {
+    return;
+  }
+  notification_dirty_ = false;
+
+  JsonDocument delta;
+  JsonObject update = delta["updates"].add<JsonObject>();
+  if (clock_sync != nullptr) {
+    clock_sync->add_timestamp(update);
+  }
+  JsonObject entry = update["values"].add<JsonObject>();
+  entry["path"] = "notifications.remoteRelay.confirmLatency";
+  JsonObject value = entry["value"].to<JsonObject>();
+  value["state"] = notification_active_ ? "alert" : "normal";
+  JsonArray method = value["method"].to<JsonArray>();
+  if (notification_active_) {
+    method.add("visual");
+  }
+  value["message"] = "Relay commands are confirmed slowly";
+  String output;
+  serializeJson(delta, output);
+  sensesp_app->get_ws_client()->sendTXT(output);
+}
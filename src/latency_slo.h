@@ -0,0 +1,99 @@
+// Press-to-confirm latency objective with self-healing actions
+//
+// LatencySlo collects the time from a channel command to the confirmed
+// state, as measured by the channel store, in a histogram per channel.
+// Commands the store still has pending after kTimeoutMs count in the
+// overflow bucket, so a half-dead connection shows up as slow instead of as
+// silence. The per-channel histograms are folded into a sliding window of
+// kNumSlices slices. At the end of every slice the objective, e.g. "99% of
+// commands confirmed within 500 ms over a minute", is checked against the
+// window.
+//
+// While the objective is missed, actions escalate one step per window:
+//  1. reconnect the SignalK websocket,
+//  2. fall back from compact commands to plain PUTs for the connection,
+//  3. raise notifications.remoteRelay.confirmLatency.
+// When the objective is met for a whole window, escalation starts over and
+// the notification is cleared. Each action is logged and published under
+// sensorDevice.<hostname>.sloAction with the latency of the window before
+// it and of the first full window after it.
+
+#ifndef LATENCY_SLO_H_
+#define LATENCY_SLO_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "channel_config.h"
+#include "channel_store.h"
+#include "compact_commands.h"
+#include "sensesp/system/observablevalue.h"
+
+class LatencySlo {
+ public:
+  static constexpr int kNumBuckets = 14;
+  // Upper bucket bounds in milliseconds; the last bucket is unbounded.
+  static constexpr uint16_t kBucketMs[kNumBuckets - 1] = {
+      25, 50, 100, 200, 300, 500, 750, 1000, 1500, 2000, 3000, 5000, 10000};
+  static constexpr uint32_t kTimeoutMs = 10000;
+  static constexpr int kNumSlices = 6;
+
+  LatencySlo(ChannelStore* store, CompactCommands* compact,
+             float quantile = 0.99, uint32_t objective_ms = 500,
+             uint32_t window_ms = 60000, uint32_t min_samples = 10);
+
+  // A command was confirmed after latency_ms, as returned by
+  // ChannelStore::confirm(); negative values are ignored.
+  void confirmed(int channel, int32_t latency_ms);
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& quantile_latency_s() {
+    return quantile_latency_s_;
+  }
+  sensesp::ObservableValue<float>& median_latency_s() {
+    return median_latency_s_;
+  }
+  sensesp::ObservableValue<float>& escalation() { return escalation_; }
+
+ private:
+  enum class Action : uint8_t { kNone = 0, kReconnect, kFallBack, kNotify };
+
+  static int bucket(uint32_t latency_ms);
+  // Latency below which the given share of the samples fall, as the upper
+  // bound of its bucket.
+  static uint32_t quantile_ms(const uint32_t* counts, float quantile);
+
+  void record(int channel, uint32_t latency_ms);
+  void rotate();
+  void evaluate(const uint32_t* window, uint32_t total);
+  void take_action(Action action, uint32_t latency_ms);
+  void publish_action(uint32_t after_ms);
+  void flush_notification();
+
+  ChannelStore* store_;
+  CompactCommands* compact_;
+  const uint32_t slice_ms_;
+  const float quantile_;
+  const uint32_t objective_ms_;
+  const uint32_t min_samples_;
+
+  uint16_t channel_counts_[kMaxChannels][kNumBuckets] = {};
+  uint32_t slice_counts_[kNumSlices][kNumBuckets] = {};
+  int slice_ = 0;
+  // Channel with the highest mean latency in the last slice, for the log.
+  int slowest_channel_ = -1;
+
+  Action last_action_ = Action::kNone;
+  uint32_t last_action_before_ms_ = 0;
+  // Slices since the last action; its effect is judged after a window.
+  int slices_since_action_ = 0;
+  bool notification_active_ = false;
+  bool notification_dirty_ = false;
+
+  sensesp::ObservableValue<float> quantile_latency_s_;
+  sensesp::ObservableValue<float> median_latency_s_;
+  sensesp::ObservableValue<float> escalation_;
+};
+
+#endif  // LATENCY_SLO_H_
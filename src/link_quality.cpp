@@ -0,0 +1,102 @@
+#include "link_quality.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "sensesp.h"
+
+using namespace sensesp;
+
+namespace {
+
+// RFC 6298 gains.
+constexpr float kRttAlpha = 1.0 / 8;
+constexpr float kRttBeta = 1.0 / 4;
+// Weight of each delivery in the loss rate.
+constexpr float kLossGain = 1.0 / 16;
+constexpr float kReconnectHalfLifeS = 60;
+
+// Round trips at which the link counts as perfect and as useless.
+constexpr float kGoodRttMs = 100;
+constexpr float kBadRttMs = 1000;
+
+constexpr uint32_t kMaxAckTimeoutMs = 10000;
+
+}  // namespace
+
+LinkQuality::LinkQuality(ConnectionMonitor* connection,
+                         unsigned int update_interval_ms)
+    : connection_(connection), update_interval_ms_(update_interval_ms) {
+  event_loop()->onRepeat(update_interval_ms, [this]() { update(); });
+}
+
+void LinkQuality::add_rtt_sample(uint32_t rtt_ms) {
+  if (!has_rtt_) {
+    srtt_ms_ = rtt_ms;
+    rttvar_ms_ = rtt_ms / 2.0;
+    has_rtt_ = true;
+    return;
+  }
+  rttvar_ms_ = (1 - kRttBeta) * rttvar_ms_ +
+               kRttBeta * std::fabs(srtt_ms_ - static_cast<float>(rtt_ms));
+  srtt_ms_ = (1 - kRttAlpha) * srtt_ms_ + kRttAlpha * rtt_ms;
+}
+
+void LinkQuality::add_delivery(bool delivered) {
+  loss_rate_ += kLossGain * ((delivered ? 0 : 1) - loss_rate_);
+}
+
+uint32_t LinkQuality::ack_timeout_ms(ChannelPriority priority) const {
+  uint32_t base = kAckTimeoutMs[static_cast<int>(priority)];
+  if (!has_rtt_) {
+    return base;
+  }
+  uint32_t rto = srtt_ms_ + 4 * rttvar_ms_;
+  return std::min(std::max(base, rto), kMaxAckTimeoutMs);
+}
+
+uint32_t LinkQuality::batch_window_ms() const {
+  switch (grade_) {
+    case LinkGrade::kFair:
+      return 20;
+    case LinkGrade::kPoor:
+      return 50;
+    default:
+      // Nothing to batch for while disconnected; the queue holds anyway.
+      return 0;
+  }
+}
+
+void LinkQuality::update() {
+  uint32_t reconnects = connection_->reconnects();
+  reconnect_penalty_ += reconnects - reconnects_seen_;
+  reconnects_seen_ = reconnects;
+  reconnect_penalty_ *=
+      std::exp2(-(update_interval_ms_ / 1000.0f) / kReconnectHalfLifeS);
+
+  float rtt_factor = 1;
+  if (has_rtt_) {
+    rtt_factor = 1 - (srtt_ms_ - kGoodRttMs) / (kBadRttMs - kGoodRttMs);
+    rtt_factor = std::min(std::max(rtt_factor, 0.0f), 1.0f);
+  }
+  float loss_factor = std::max(1 - 2 * loss_rate_, 0.0f);
+  float reconnect_factor = 1 / (1 + reconnect_penalty_);
+  score_ = connection_->connected()
+               ? rtt_factor * loss_factor * reconnect_factor
+               : 0;
+
+  if (!connection_->connected()) {
+    grade_ = LinkGrade::kDown;
+  } else if (score_ >= 0.8) {
+    grade_ = LinkGrade::kGood;
+  } else if (score_ >= 0.5) {
+    grade_ = LinkGrade::kFair;
+  } else {
+    grade_ = LinkGrade::kPoor;
+  }
+
+  rtt_s_.set(srtt_ms_ / 1000.0);
+  rtt_variation_s_.set(rttvar_ms_ / 1000.0);
+  loss_.set(loss_rate_);
+  score_value_.set(score_);
+}
@@ -0,0 +1,83 @@
+// Link quality estimate for the SignalK connection
+//
+// LinkQuality estimates the quality of the link to the SignalK server from
+// round trip times, lost requests and reconnects. Round trips come from the
+// clock sync requests and from relay PUTs confirmed by the listeners. A PUT
+// that is never confirmed, or a clock request that is never answered,
+// counts as lost. The websocket client does not expose its ping/pong
+// timing, so these request round trips are used instead.
+//
+// The smoothed round trip and its variation follow RFC 6298. The loss rate
+// is a moving average, and reconnects add a penalty that decays with a
+// half-life of a minute. Together they give a score from 0 to 1 and a grade.
+// The other modules derive their transport settings from these:
+//  - the ack timeout before a PUT is retried,
+//  - the batching window for commands,
+//  - whether status LEDs show a command before it is confirmed,
+//  - whether a standby controller with a better link should take over.
+// The estimate is published as diagnostics.
+
+#ifndef LINK_QUALITY_H_
+#define LINK_QUALITY_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "channel_config.h"
+#include "connection_monitor.h"
+#include "sensesp/system/observablevalue.h"
+
+enum class LinkGrade : uint8_t { kGood = 0, kFair, kPoor, kDown };
+
+class LinkQuality {
+ public:
+  LinkQuality(ConnectionMonitor* connection,
+              unsigned int update_interval_ms = 1000);
+
+  void add_rtt_sample(uint32_t rtt_ms);
+  // A request was answered, or given up on.
+  void add_delivery(bool delivered);
+
+  float score() const { return score_; }
+  LinkGrade grade() const { return grade_; }
+
+  // Time to wait for a confirmation before retrying; never shorter than the
+  // priority class's default.
+  uint32_t ack_timeout_ms(ChannelPriority priority) const;
+  // Time non-critical commands are held so that more go out in one batch.
+  uint32_t batch_window_ms() const;
+  // Show commands on the status LEDs before they are confirmed.
+  bool predict_leds() const { return grade_ != LinkGrade::kGood; }
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& rtt_s() { return rtt_s_; }
+  sensesp::ObservableValue<float>& rtt_variation_s() {
+    return rtt_variation_s_;
+  }
+  sensesp::ObservableValue<float>& loss() { return loss_; }
+  sensesp::ObservableValue<float>& score_value() { return score_value_; }
+
+ private:
+  void update();
+
+  ConnectionMonitor* connection_;
+  const unsigned int update_interval_ms_;
+
+  bool has_rtt_ = false;
+  float srtt_ms_ = 0;
+  float rttvar_ms_ = 0;
+  float loss_rate_ = 0;
+  float reconnect_penalty_ = 0;
+  uint32_t reconnects_seen_ = 0;
+
+  float score_ = 1;
+  LinkGrade grade_ = LinkGrade::kDown;
+
+  sensesp::ObservableValue<float> rtt_s_;
+  sensesp::ObservableValue<float> rtt_variation_s_;
+  sensesp::ObservableValue<float> loss_;
+  sensesp::ObservableValue<float> score_value_;
+};
+
+#endif  // LINK_QUALITY_H_
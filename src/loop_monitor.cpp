@@ -0,0 +1,26 @@
+#include "loop_monitor.h"
+
+#include "sensesp.h"
+
+using namespace sensesp;
+
+LoopMonitor::LoopMonitor(unsigned int interval_ms) {
+  event_loop()->onTick([this]() { tick(); });
+  event_loop()->onRepeat(interval_ms, [this]() { publish(); });
+}
+
+void LoopMonitor::tick() {
+  uint32_t now = micros();
+  if (last_tick_us_ != 0) {
+    uint32_t gap = now - last_tick_us_;
+    if (gap > max_gap_us_) {
+      max_gap_us_ = gap;
+    }
+  }
+  last_tick_us_ = now;
+}
+
+void LoopMonitor::publish() {
+  max_stall_s_.set(max_gap_us_ / 1e6);
+  max_gap_us_ = 0;
+}
@@ -0,0 +1,35 @@
+// Event loop stall measurement
+//
+// LoopMonitor measures the time between consecutive event loop ticks. The
+// longest gap in each interval is the worst delay a button press could have
+// seen, whether caused by the loop itself or by other tasks such as the
+// HTTP server competing for the CPU. It is published as a diagnostic.
+
+#ifndef LOOP_MONITOR_H_
+#define LOOP_MONITOR_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "sensesp/system/observablevalue.h"
+
+class LoopMonitor {
+ public:
+  LoopMonitor(unsigned int interval_ms = 10000);
+
+  uint32_t max_gap_us() const { return max_gap_us_; }
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& max_stall_s() { return max_stall_s_; }
+
+ private:
+  void tick();
+  void publish();
+
+  uint32_t last_tick_us_ = 0;
+  uint32_t max_gap_us_ = 0;
+  sensesp::ObservableValue<float> max_stall_s_;
+};
+
+#endif  // LOOP_MONITOR_H_
@@ -6,10 +6,33 @@
 // SKValueListener listens on the same path so that a status LED shows the
 // current state as reported by the SignalK server.
 
+#include <WiFi.h>
 #include <Wire.h>
 
+#include <functional>
+#include <initializer_list>
 #include <memory>
+#include <vector>
 
+#include "actuator_bank.h"
+#include "astro_schedule.h"
+#include "board_profile.h"
+#include "channel_alarms.h"
+#include "channel_config.h"
+#include "channel_meta.h"
+#include "channel_store.h"
+#include "clock_sync.h"
+#include "compact_commands.h"
+#include "connection_monitor.h"
+#include "control_panel.h"
+#include "diagnostics.h"
+#include "dimmer_bank.h"
+#include "latency_slo.h"
+#include "link_quality.h"
+#include "loop_monitor.h"
+#include "mirror_bank.h"
+#include "modbus_relay_board.h"
+#include "relay_lease.h"
 #include "sensesp.h"
 #include "sensesp/sensors/digital_input.h"  // DigitalInputChange
 #include "sensesp/sensors/digital_output.h"
@@ -18,16 +41,110 @@
 #include "sensesp/system/lambda_consumer.h"
 #include "sensesp/ui/config_item.h"
 #include "sensesp_app_builder.h"
-
-#define I2C_SDA 21
-#define I2C_SCL 22
+#include "standby_pair.h"
+#include "state_api.h"
+#include "state_dispatcher.h"
+#include "timestamped_put_request.h"
+#include "touch_input.h"
+#include "transmit_queue.h"
+#include "web_assets.h"
 
 using namespace sensesp;
 using namespace reactesp;
 
+// Use the board's touch pads instead of pushbuttons, for sealed panels.
+constexpr bool kTouchButtons = false;
+static_assert(!kTouchButtons || board::kHasTouch,
+              "The board has no touch pads");
+
+// Button (or touch pad) and status LED pins of the board's channel slots;
+// see board_profile.h.
+#define SLOT(n)                                                   \
+  (kTouchButtons ? board::kTouchPins[n] : board::kButtonPins[n]), \
+      board::kLedPins[n]
+
+// Relay channels: channel slot, default SignalK path, priority class,
+// whether the relay is leased and, optionally, the channel role and relay
+// output pin. For example, a bilge pump relay on GPIO 26 of this device
+// would be
+//   {SLOT(0), "electrical.switches.bilgePump.state",
+//    ChannelPriority::kCritical, false, ChannelRole::kActuator, 26},
+// and coil 3 of the Modbus relay board below would be
+//   {SLOT(1), "electrical.switches.deck.state", ChannelPriority::kNormal,
+//    false, ChannelRole::kModbus, -1, 3},
+constexpr ChannelConfig kChannels[] = {
+    {SLOT(0), "electrical.switches.light.cabin.state", ChannelPriority::kLow,
+     false},
+    {SLOT(1), "electrical.switches.light.port.state",
+     ChannelPriority::kCritical, false},
+    {SLOT(2), "electrical.switches.light.starboard.state",
+     ChannelPriority::kCritical, false},
+    {SLOT(3), "electrical.switches.light.engine.state",
+     ChannelPriority::kNormal, true},
+};
+constexpr int kNumChannels = sizeof(kChannels) / sizeof(kChannels[0]);
+static_assert(kNumChannels <= kMaxChannels, "Too many relay channels");
+static_assert(kNumChannels <= board::kNumSlots,
+              "More relay channels than the board has slots");
+
+constexpr bool uses_role(ChannelRole role, int i = 0) {
+  return i < kNumChannels &&
+         (kChannels[i].role == role || uses_role(role, i + 1));
+}
+
+// Backends needed by the channel table. Those not needed are never
+// constructed, and their code is dropped from the build.
+constexpr bool kUsesActuators = uses_role(ChannelRole::kActuator);
+constexpr bool kUsesModbus = uses_role(ChannelRole::kModbus);
+static_assert(!kUsesActuators || board::kHasRelayOutputs,
+              "The board has no pins for relay outputs");
+
+// Dimmable lights: dimmingLevel path and PWM output pin on this device (-1
+// for a dimmer elsewhere). Dimmers elsewhere that run fades themselves are
+// not listed. For example, a saloon light dimmer on GPIO 27 would be
+//   {"electrical.switches.light.saloon.dimmingLevel", 27},
+constexpr std::initializer_list<DimmerConfig> kDimmers = {};
+
+constexpr bool uses_pwm(const DimmerConfig* dimmer) {
+  return dimmer != kDimmers.end() &&
+         (dimmer->pwm_pin >= 0 || uses_pwm(dimmer + 1));
+}
+static_assert(!uses_pwm(kDimmers.begin()) || board::kHasPwm,
+              "The board has no pins for dimmer outputs");
+
+// Channels switched at solar events for the vessel's position. For example,
+// an anchor light on channel 0, on at sunset and off at sunrise, would be
+//   {0, SolarEvent::kSunset, SolarEvent::kSunrise},
+const std::vector<AstroRule> kAstroRules = {};
+
+// Display-only mirrors of paths switched elsewhere: path, indicator pin (-1
+// for none) and a bit mask of aggregate groups. The tables stay in flash.
+// For example, a galley repeater showing the deck lights would be
+//   {"electrical.switches.light.deck.fore.state", 32, 0b1},
+//   {"electrical.switches.light.deck.aft.state", 33, 0b1},
+// with the group {"deckLights", 27} lit while either is on.
+constexpr std::initializer_list<MirrorConfig> kMirrors = {};
+constexpr std::initializer_list<MirrorGroupConfig> kMirrorGroups = {};
+
+// Modbus TCP relay board for ChannelRole::kModbus channels.
+const char* kModbusHost = "192.168.4.50";
+const uint16_t kModbusPort = 502;
+const uint8_t kModbusUnitId = 1;
+
+// Peer controller for active/standby pairing, or nullptr to run alone. Both
+// controllers need the same channel table.
+const char* kStandbyPeer = nullptr;
+
+// Token the control panel websocket requires, passed as ?token= on the
+// control page URL. The panel is not started while it is empty.
+const char* kPanelToken = "";
+
 void setup() {
   SetupLogging(ESP_LOG_DEBUG);
-  Wire.begin(I2C_SDA, I2C_SCL);
+  debugI("Board profile: %s", board::kName);
+  if (board::kHasI2c) {
+    Wire.begin(board::kI2cSda, board::kI2cScl);
+  }
 
   // Build the SensESP application.
   SensESPAppBuilder builder;
@@ -36,77 +153,327 @@ void setup() {
                     ->set_wifi_client("Obelix", "obelix2idefix")
                     ->get_app();
 
-  const int num_relays = 4;
+  // Estimate the clock offset to the server so that commands carry
+  // comparable timestamps.
+  clock_sync = new ClockSync();
+  publish_diagnostic(&clock_sync->offset_s(), "clockOffset", "s");
+  publish_diagnostic(&clock_sync->uncertainty_s(), "clockOffsetUncertainty",
+                     "s");
+
+  // SignalK connection state, for the link quality estimate.
+  auto* connection = new ConnectionMonitor();
+  publish_diagnostic(&connection->reconnect_count(), "wsReconnects", "");
+
+  // Link quality from round trips, losses and reconnects; tunes retries,
+  // batching, LED prediction and standby failover.
+  auto* link = new LinkQuality(connection);
+  clock_sync->set_link_quality(link);
+  publish_diagnostic(&link->rtt_s(), "linkRtt", "s");
+  publish_diagnostic(&link->rtt_variation_s(), "linkRttVariation", "s");
+  publish_diagnostic(&link->loss(), "linkLoss", "ratio");
+  publish_diagnostic(&link->score_value(), "linkQuality", "ratio");
+
+  // Longest gap between event loop ticks, e.g. while serving web pages.
+  auto* loop_monitor = new LoopMonitor();
+  publish_diagnostic(&loop_monitor->max_stall_s(), "eventLoopStallMax", "s");
+
+  // Confirmed and commanded state of every channel, shared by the modules
+  // below.
+  auto* store = new ChannelStore();
+
+  // Precompressed web UI under /relays/, with a websocket for the virtual
+  // control panel.
+  new WebAssetServer();
+  auto* panel = new ControlPanel(store, kPanelToken);
+  // Versioned state snapshots for other systems on board.
+  new StateApi(store);
+
+  // Raises SignalK notifications for unconfirmed commands, readback
+  // mismatches and stuck buttons.
+  auto* alarms = new ChannelAlarms(store);
+  auto* lease = new RelayLease();
+
+  // PUTs go through a transmit queue that keeps only the newest pending
+  // state per channel and sends critical channels first.
+  auto* tx_queue = new TransmitQueue(store);
+  for (int p = 0; p < kNumPriorities; p++) {
+    auto priority = static_cast<ChannelPriority>(p);
+    String name = String("txQueueLatency.") + kPriorityNames[p];
+    publish_diagnostic(&tx_queue->mean_latency_s(priority), name.c_str(), "s");
+    name = String("txQueueLatencyMax.") + kPriorityNames[p];
+    publish_diagnostic(&tx_queue->max_latency_s(priority), name.c_str(), "s");
+  }
+  publish_diagnostic(&tx_queue->superseded(), "txQueueSuperseded", "");
+
+  // Batched, path-interned commands when the server plugin supports them.
+  auto* compact = new CompactCommands();
+  tx_queue->set_compact_commands(compact);
+  tx_queue->set_link_quality(link);
+
+  // Press-to-confirm latency objective: p99 within 500 ms over a minute,
+  // with escalating self-healing actions when it is missed.
+  auto* slo = new LatencySlo(store, compact, 0.99, 500, 60000);
+  publish_diagnostic(&slo->quantile_latency_s(), "confirmLatencyP99", "s");
+  publish_diagnostic(&slo->median_latency_s(), "confirmLatencyMedian", "s");
+  publish_diagnostic(&slo->escalation(), "sloEscalation", "");
 
-  // Define arrays for button and LED pins.
-  int buttonPins[num_relays] = {16, 17, 18, 19};
-  int statusLEDPins[num_relays] = {12, 13, 14, 15};
+  // Channel descriptions, published as one meta delta per connection.
+  auto* meta = new ChannelMetaPublisher();
 
-  // Default SignalK paths for each relay channel.
-  const char* default_sk_paths[num_relays] = {
-      "electrical.switches.light.cabin.state",
-      "electrical.switches.light.port.state",
-      "electrical.switches.light.starboard.state",
-      "electrical.switches.light.engine.state"};
+  // Incoming states are handled once per tick in priority order, a few
+  // channels per tick, and after any pending button input.
+  auto* dispatcher = new StateDispatcher();
+  publish_diagnostic(&dispatcher->coalesced(), "ingressCoalesced", "");
+  publish_diagnostic(&dispatcher->deferred(), "ingressDeferred", "");
+  tx_queue->set_state_dispatcher(dispatcher);
 
-  for (int i = 0; i < num_relays; i++) {
+  // Relays driven by this device. Their state changes feed the status LEDs
+  // like states reported by the server.
+  ActuatorBank* actuators = nullptr;
+  if (kUsesActuators) {
+    actuators = new ActuatorBank();
+    actuators->set_commit_callback([dispatcher](int channel, bool state) {
+      dispatcher->post(channel, state);
+    });
+  }
+
+  // Coils of a Modbus relay board, written and read back in batches.
+  ModbusRelayBoard* modbus_board = nullptr;
+  if (kUsesModbus) {
+    modbus_board = new ModbusRelayBoard(new ModbusTcpLink(
+        new WiFiClient(), kModbusHost, kModbusPort, kModbusUnitId));
+    modbus_board->set_state_callback([dispatcher](int channel, bool state) {
+      dispatcher->post(channel, state);
+    });
+    publish_diagnostic(&modbus_board->mean_latency_s(), "modbusLatency", "s");
+    publish_diagnostic(&modbus_board->max_latency_s(), "modbusLatencyMax",
+                       "s");
+    publish_diagnostic(&modbus_board->transactions_per_s(),
+                       "modbusTransactionRate", "Hz");
+    publish_diagnostic(&modbus_board->errors(), "modbusErrors", "");
+  }
+
+  if (kMirrors.size() > 0) {
+    new MirrorBank(kMirrors.begin(), kMirrors.size(), kMirrorGroups.begin(),
+                   kMirrorGroups.size());
+  }
+
+  // Dimmers take fade commands on their fade paths; see dimmer_bank.h.
+  if (kDimmers.size() > 0) {
+    auto* dimmers = new DimmerBank();
+    for (size_t i = 0; i < kDimmers.size(); i++) {
+      dimmers->add_dimmer(i, kDimmers.begin()[i]);
+    }
+  }
+
+  // A standby controller forwards its commands to the active one and takes
+  // over when the active one falls silent.
+  StandbyPair* standby = nullptr;
+  if (kStandbyPeer != nullptr) {
+    standby = new StandbyPair(store, kStandbyPeer);
+    standby->set_link_quality(link);
+    publish_diagnostic(&standby->role(), "standbyActive", "");
+    publish_diagnostic(&standby->takeover_time_s(), "standbyTakeoverTime",
+                       "s");
+  }
+
+  // Per-channel commands, for the solar schedule and the standby pair.
+  auto* channel_commands = new std::function<void(bool)>[kNumChannels];
+
+  const uint32_t heap_before_channels = ESP.getFreeHeap();
+  for (int i = 0; i < kNumChannels; i++) {
     int relayIndex = i;  // Capture index for lambda
+    const ChannelConfig& channel = kChannels[relayIndex];
 
     // Create a pushbutton input using DigitalInputChange.
-    // The button is assumed active LOW (with INPUT_PULLUP).
-    auto* button =
-        new DigitalInputChange(buttonPins[relayIndex], INPUT_PULLUP, CHANGE);
+    // The button is assumed active LOW (with INPUT_PULLUP). Touch pads
+    // report touches the same way.
+    ValueProducer<bool>* button;
+    if (kTouchButtons) {
+      button = new TouchInput(channel.button_pin);
+    } else {
+      button = new DigitalInputChange(channel.button_pin, INPUT_PULLUP, CHANGE);
+    }
 
     // Add a debounce transform (50 ms period).
     auto* debouncer = new Debounce<bool>(50);
     button->connect_to(debouncer);
+    button->connect_to(new LambdaConsumer<bool>(
+        [dispatcher](bool state) { dispatcher->input_event(); }));
 
-    // Create an SKPutRequest to send a PUT command.
-    std::string configPath =
-        "/Remote/Control/Relay" + std::to_string(relayIndex + 1) + "/Value";
-    const char* sk_path = default_sk_paths[relayIndex];
     std::string sk_meta_desc = "Remote control relay state for relay " +
                 std::to_string(relayIndex + 1);
-    std::string relay_title = "Relay " + std::to_string(relayIndex + 1) + " Path";
-    auto* sk_put_request =
-        new SKPutRequest<bool>(sk_path, configPath.c_str());
-    // Wrap the SKPutRequest in a ConfigItem so its SignalK path is
-    // configurable.
-    ConfigItem(sk_put_request)
-        ->set_title(relay_title.c_str())
-        ->set_sort_order(100 + relayIndex);
-
-    // Create an SKValueListener to listen for state updates.
-    // (Second parameter is a sort order.)
-    auto* sk_value_listener =
-        new SKValueListener<bool>(sk_path, 200 + relayIndex);
+    std::string display_name = "Relay " + std::to_string(relayIndex + 1);
+
+    store->add_channel(relayIndex);
 
     // Create a DigitalOutput for a status LED.
-    auto* status_led = new DigitalOutput(statusLEDPins[relayIndex]);
-    sk_value_listener->connect_to(
-        new LambdaConsumer<bool>([status_led, relayIndex](bool state) {
+    auto* status_led = new DigitalOutput(channel.led_pin);
+    dispatcher->add_channel(
+        relayIndex, channel.priority,
+        [status_led, alarms, tx_queue, store, slo, relayIndex](bool state) {
           status_led->set(state);
+          slo->confirmed(relayIndex, store->confirm(relayIndex, state));
+          alarms->state_received(relayIndex, state);
+          tx_queue->state_received(relayIndex, state);
           debugD("Remote Control: Received state for relay %d: %d",
                  relayIndex + 1, state);
-        }));
+        });
 
-    // Local variable to store current command state for this channel.
-    bool* current_state = new bool(false);
+    // Commands the channel's relay; shared by the button and the web panel.
+    std::function<void(bool)> command;
+    // The state a button press toggles from.
+    std::function<bool()> commanded_state;
 
-    // When the debounced button is pressed (LOW), toggle state and send a PUT
-    // command.
+    if (kUsesActuators && channel.role == ChannelRole::kActuator) {
+      // The relay is on this device: commands switch it directly and PUTs
+      // from other controllers are served locally.
+      actuators->add_channel(relayIndex, channel.relay_pin, channel.sk_path);
+      meta->add_channel(relayIndex, channel.sk_path, sk_meta_desc.c_str(),
+                        display_name.c_str());
+      command = [actuators, relayIndex](bool state) {
+        actuators->command(relayIndex, state);
+      };
+      commanded_state = [actuators, relayIndex]() {
+        return actuators->state(relayIndex);
+      };
+    } else if (kUsesModbus && channel.role == ChannelRole::kModbus) {
+      modbus_board->add_channel(relayIndex, channel.coil);
+      meta->add_channel(relayIndex, channel.sk_path, sk_meta_desc.c_str(),
+                        display_name.c_str());
+      command = [modbus_board, relayIndex](bool state) {
+        modbus_board->command(relayIndex, state);
+      };
+      // Toggle from the last command, not the read-back, so that a second
+      // press before the write completes switches back.
+      commanded_state = [store, relayIndex]() {
+        return store->commanded(relayIndex);
+      };
+    } else {
+      // Create an SKPutRequest to send a PUT command. PUTs are stamped with
+      // the corrected server time.
+      std::string configPath =
+          "/Remote/Control/Relay" + std::to_string(relayIndex + 1) + "/Value";
+      const char* sk_path = channel.sk_path;
+      std::string relay_title =
+          "Relay " + std::to_string(relayIndex + 1) + " Path";
+      auto* sk_put_request =
+          new TimestampedPutRequest<bool>(sk_path, configPath.c_str());
+      alarms->add_channel(relayIndex, sk_put_request);
+      meta->add_channel(relayIndex, sk_put_request, sk_meta_desc.c_str(),
+                        display_name.c_str());
+      tx_queue->add_channel(relayIndex, sk_put_request, channel.priority);
+      compact->add_channel(relayIndex, sk_put_request);
+      if (channel.leased) {
+        lease->add_channel(relayIndex, sk_put_request);
+      }
+      // Wrap the SKPutRequest in a ConfigItem so its SignalK path is
+      // configurable.
+      ConfigItem(sk_put_request)
+          ->set_title(relay_title.c_str())
+          ->set_sort_order(100 + relayIndex);
+
+      // Create an SKValueListener to listen for state updates.
+      // (Second parameter is a sort order.)
+      auto* sk_value_listener =
+          new SKValueListener<bool>(sk_path, 200 + relayIndex);
+
+      sk_value_listener->connect_to(
+          new LambdaConsumer<bool>([dispatcher, relayIndex](bool state) {
+            dispatcher->post(relayIndex, state);
+          }));
+
+      command = [sk_put_request, actuators, tx_queue, lease,
+                 relayIndex](bool state) {
+        // Skip the server round trip if the relay is on this device.
+        if (!kUsesActuators ||
+            !actuators->apply_local(sk_put_request->get_sk_path(), state)) {
+          tx_queue->enqueue(relayIndex);
+          lease->command_sent(relayIndex, state);
+        }
+      };
+      commanded_state = [store, relayIndex]() {
+        return store->commanded(relayIndex);
+      };
+    }
+
+    // Record every command until it is confirmed. On a slow link, show it
+    // on the LED right away; the confirmed state overrides it when it
+    // arrives.
+    command = [link, store, status_led, command, relayIndex](bool state) {
+      store->command(relayIndex, state);
+      if (link->predict_leds()) {
+        status_led->set(state);
+      }
+      command(state);
+    };
+
+    if (standby) {
+      // Only the active controller sends commands. The standby's buttons
+      // toggle the replicated state.
+      command = [standby, command, relayIndex](bool state) {
+        if (!standby->is_active()) {
+          standby->forward(relayIndex, state);
+          return;
+        }
+        command(state);
+      };
+      commanded_state = [store, relayIndex]() {
+        return store->commanded(relayIndex);
+      };
+    }
+
+    panel->add_channel(relayIndex, display_name.c_str(), command);
+    channel_commands[relayIndex] = command;
+
+    // When the debounced button is pressed (LOW), toggle the state.
     debouncer->connect_to(new LambdaConsumer<bool>(
-        [sk_put_request, current_state, relayIndex](bool state) {
+        [command, commanded_state, alarms, relayIndex](bool state) {
           // LOW (false) indicates a button press with INPUT_PULLUP.
+          alarms->button_changed(relayIndex, !state);
           if (!state) {
-            *current_state = !(*current_state);
-            sk_put_request->set(*current_state);
+            bool new_state = !commanded_state();
+            command(new_state);
             debugD("Remote Control: Button for relay %d pressed, new state: %d",
-                   relayIndex + 1, *current_state);
+                   relayIndex + 1, new_state);
           }
         }));
   }
 
+  // Heap taken by the channel setup on the device, including SensESP's
+  // objects. The native tests hold the baselines for the parts of it this
+  // project controls.
+  uint32_t heap_per_channel =
+      (heap_before_channels - ESP.getFreeHeap()) / kNumChannels;
+  auto* channel_heap = new ObservableValue<float>();
+  publish_diagnostic(channel_heap, "heapPerChannel", "B");
+  channel_heap->set(heap_per_channel);
+  debugI("Channel setup takes %u B of heap per channel", heap_per_channel);
+
+  if (standby) {
+    // The active controller renews the leases of the channels commanded on,
+    // including those the old active controller took.
+    standby->set_role_handler([lease, store](bool active) {
+      lease->hold(active ? store->commanded_states() : ChannelSet());
+    });
+    standby->set_command_handler([channel_commands](int channel, bool state) {
+      if (channel < kNumChannels) {
+        channel_commands[channel](state);
+      }
+    });
+  }
+
+  if (!kAstroRules.empty()) {
+    auto* schedule = new AstroSchedule();
+    for (const AstroRule& rule : kAstroRules) {
+      if (rule.channel < 0 || rule.channel >= kNumChannels) {
+        debugE("Schedule rule for unknown channel %d", rule.channel);
+        continue;
+      }
+      schedule->add_rule(rule, channel_commands[rule.channel]);
+    }
+  }
+
   while (true) {
     loop();
   }
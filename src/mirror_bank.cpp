@@ -0,0 +1,76 @@
+#include "mirror_bank.h"
+
+#include <ArduinoJson.h>
+
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_listener.h"
+
+using namespace sensesp;
+
+namespace {
+
+// Subscription for one mirrored path; only a back pointer and an index on
+// top of the SensESP listener.
+class MirrorListener : public SKListener {
+ public:
+  MirrorListener(const char* sk_path, MirrorBank* bank, uint16_t index)
+      : SKListener(sk_path, 500), bank_(bank), index_(index) {}
+
+  void parse_value(const JsonObject& json) override {
+    bank_->set(index_, json["value"].as<bool>());
+  }
+
+ private:
+  MirrorBank* bank_;
+  uint16_t index_;
+};
+
+}  // namespace
+
+MirrorBank::MirrorBank(const MirrorConfig* mirrors, size_t num_mirrors,
+                       const MirrorGroupConfig* groups, size_t num_groups)
+    : mirrors_(mirrors),
+      groups_(groups),
+      num_groups_(num_groups < kMaxGroups ? num_groups : kMaxGroups),
+      states_((num_mirrors + 31) / 32),
+      known_((num_mirrors + 31) / 32) {
+  if (num_groups > kMaxGroups) {
+    debugE("Only %d mirror groups are supported", kMaxGroups);
+  }
+  for (size_t g = 0; g < num_groups_; g++) {
+    pinMode(groups_[g].led_pin, OUTPUT);
+    digitalWrite(groups_[g].led_pin, LOW);
+  }
+  for (size_t i = 0; i < num_mirrors; i++) {
+    if (mirrors_[i].led_pin >= 0) {
+      pinMode(mirrors_[i].led_pin, OUTPUT);
+      digitalWrite(mirrors_[i].led_pin, LOW);
+    }
+    new MirrorListener(mirrors_[i].sk_path, this, i);
+  }
+}
+
+void MirrorBank::set(size_t mirror, bool state) {
+  bool was_on = test(known_, mirror) && test(states_, mirror);
+  assign(known_, mirror, true);
+  if (state == was_on) {
+    return;
+  }
+  assign(states_, mirror, state);
+
+  const MirrorConfig& config = mirrors_[mirror];
+  if (config.led_pin >= 0) {
+    digitalWrite(config.led_pin, state ? HIGH : LOW);
+  }
+  for (size_t g = 0; g < num_groups_; g++) {
+    if (!(config.groups >> g & 1)) {
+      continue;
+    }
+    uint16_t& count = on_count_[g];
+    bool was_lit = count > 0;
+    count += state ? 1 : -1;
+    if ((count > 0) != was_lit) {
+      digitalWrite(groups_[g].led_pin, count > 0 ? HIGH : LOW);
+    }
+  }
+}
@@ -0,0 +1,58 @@
+// Display-only mirrors of relay states
+//
+// A repeater panel, e.g. in the galley, shows relay states without
+// controlling them. MirrorBank subscribes to each mirrored path and drives
+// its indicator output; there is no button, debounce or PUT request. Paths
+// can belong to groups with an aggregate indicator such as "any deck light
+// on". Each group keeps a count of its paths that are on, which every state
+// change adjusts by one, so no sweep over the members is needed.
+//
+// The configuration table stays in flash. Apart from the SensESP listener
+// each path needs for its subscription, a mirrored path takes two bits of
+// RAM, its state and whether it is known, so one device can mirror
+// hundreds of paths.
+
+#ifndef MIRROR_BANK_H_
+#define MIRROR_BANK_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "channel_config.h"
+
+class MirrorBank {
+ public:
+  static constexpr int kMaxGroups = 8;
+
+  // The tables must outlive the bank.
+  MirrorBank(const MirrorConfig* mirrors, size_t num_mirrors,
+             const MirrorGroupConfig* groups, size_t num_groups);
+
+  // A mirrored path reported a new state.
+  void set(size_t mirror, bool state);
+
+  bool state(size_t mirror) const { return test(states_, mirror); }
+  bool any_on(int group) const { return on_count_[group] > 0; }
+  int on_count(int group) const { return on_count_[group]; }
+
+ private:
+  static bool test(const std::vector<uint32_t>& bits, size_t i) {
+    return bits[i / 32] >> (i % 32) & 1;
+  }
+  static void assign(std::vector<uint32_t>& bits, size_t i, bool value) {
+    uint32_t mask = 1u << (i % 32);
+    bits[i / 32] = value ? bits[i / 32] | mask : bits[i / 32] & ~mask;
+  }
+
+  const MirrorConfig* mirrors_;
+  const MirrorGroupConfig* groups_;
+  const size_t num_groups_;
+
+  std::vector<uint32_t> states_;
+  std::vector<uint32_t> known_;
+  uint16_t on_count_[kMaxGroups] = {};
+};
+
+#endif  // MIRROR_BANK_H_
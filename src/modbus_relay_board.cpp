@@ -0,0 +1,406 @@
+#include "modbus_relay_board.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "sensesp.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr uint8_t kReadCoils = 0x01;
+constexpr uint8_t kWriteSingleCoil = 0x05;
+constexpr uint8_t kWriteMultipleCoils = 0x0F;
+constexpr uint8_t kExceptionFlag = 0x80;
+
+void put_u16(uint8_t* buf, uint16_t value) {
+  buf[0] = value >> 8;
+  buf[1] = value & 0xFF;
+}
+
+uint16_t get_u16(const uint8_t* buf) { return (buf[0] << 8) | buf[1]; }
+
+}  // namespace
+
+ModbusTcpLink::ModbusTcpLink(Client* client, const char* host, uint16_t port,
+                             uint8_t unit_id)
+    : client_(client), host_(host), port_(port), unit_id_(unit_id) {
+  xTaskCreate(connect_task, "modbus_connect", 4096, this, 1, &connect_task_);
+}
+
+void ModbusTcpLink::connect_task(void* arg) {
+  auto* link = static_cast<ModbusTcpLink*>(arg);
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bool ok = link->client_->connect(link->host_, link->port_);
+    link->connect_state_ =
+        ok ? ConnectState::kConnected : ConnectState::kDisconnected;
+  }
+}
+
+void ModbusTcpLink::request_connect() {
+  if (connect_state_ == ConnectState::kConnecting) {
+    return;
+  }
+  client_->stop();
+  connect_state_ = ConnectState::kConnecting;
+  xTaskNotifyGive(connect_task_);
+}
+
+bool ModbusTcpLink::send(const uint8_t* pdu, size_t len) {
+  if (connect_state_ != ConnectState::kConnected || !client_->connected()) {
+    request_connect();
+    return false;
+  }
+  transaction_id_++;
+  put_u16(buf_, transaction_id_);
+  put_u16(buf_ + 2, 0);  // protocol identifier
+  put_u16(buf_ + 4, len + 1);
+  buf_[6] = unit_id_;
+  memcpy(buf_ + kHeaderSize, pdu, len);
+  received_ = 0;
+  return client_->write(buf_, kHeaderSize + len) == kHeaderSize + len;
+}
+
+int ModbusTcpLink::receive(uint8_t* pdu) {
+  while (client_->available() > 0) {
+    size_t needed = kHeaderSize;
+    if (received_ >= kHeaderSize) {
+      needed = 6 + get_u16(buf_ + 4);
+      if (needed > sizeof(buf_) || needed <= kHeaderSize) {
+        return -1;
+      }
+    }
+    if (received_ == needed) {
+      break;
+    }
+    int n = client_->read(buf_ + received_, needed - received_);
+    if (n <= 0) {
+      break;
+    }
+    received_ += n;
+  }
+  if (received_ < kHeaderSize) {
+    return 0;
+  }
+  size_t frame_len = 6 + get_u16(buf_ + 4);
+  if (received_ < frame_len) {
+    return 0;
+  }
+  if (get_u16(buf_) != transaction_id_) {
+    return -1;
+  }
+  size_t pdu_len = frame_len - kHeaderSize;
+  memcpy(pdu, buf_ + kHeaderSize, pdu_len);
+  received_ = 0;
+  return pdu_len;
+}
+
+void ModbusTcpLink::reset() {
+  received_ = 0;
+  if (connect_state_ == ConnectState::kConnected) {
+    // Late bytes of an abandoned response would corrupt the next one.
+    client_->stop();
+    connect_state_ = ConnectState::kDisconnected;
+  }
+}
+
+uint16_t ModbusRtuLink::crc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+bool ModbusRtuLink::send(const uint8_t* pdu, size_t len) {
+  while (serial_->available() > 0) {
+    serial_->read();
+  }
+  buf_[0] = unit_id_;
+  memcpy(buf_ + 1, pdu, len);
+  uint16_t crc = crc16(buf_, len + 1);
+  // The CRC goes low byte first.
+  buf_[len + 1] = crc & 0xFF;
+  buf_[len + 2] = crc >> 8;
+  received_ = 0;
+  return serial_->write(buf_, len + 3) == len + 3;
+}
+
+size_t ModbusRtuLink::expected_length() const {
+  if (received_ < 2) {
+    return 0;
+  }
+  uint8_t function = buf_[1];
+  if (function & kExceptionFlag) {
+    return 5;
+  }
+  if (function == kReadCoils) {
+    return received_ < 3 ? 0 : 5 + buf_[2];
+  }
+  if (function == kWriteSingleCoil || function == kWriteMultipleCoils) {
+    return 8;
+  }
+  return SIZE_MAX;
+}
+
+int ModbusRtuLink::receive(uint8_t* pdu) {
+  size_t expected = 0;
+  while (serial_->available() > 0) {
+    expected = expected_length();
+    if (expected == SIZE_MAX || expected > sizeof(buf_)) {
+      return -1;
+    }
+    if (expected != 0 && received_ == expected) {
+      break;
+    }
+    buf_[received_++] = serial_->read();
+  }
+  expected = expected_length();
+  if (expected == 0 || received_ < expected) {
+    return 0;
+  }
+  if (expected == SIZE_MAX || buf_[0] != unit_id_) {
+    return -1;
+  }
+  uint16_t crc = buf_[expected - 2] | (buf_[expected - 1] << 8);
+  if (crc != crc16(buf_, expected - 2)) {
+    return -1;
+  }
+  size_t pdu_len = expected - 3;
+  memcpy(pdu, buf_ + 1, pdu_len);
+  received_ = 0;
+  return pdu_len;
+}
+
+void ModbusRtuLink::reset() { received_ = 0; }
+
+ModbusRelayBoard::ModbusRelayBoard(ModbusLink* link,
+                                   unsigned int poll_interval_ms,
+                                   unsigned int timeout_ms,
+                                   unsigned int metrics_interval_ms)
+    : link_(link),
+      poll_interval_ms_(poll_interval_ms),
+      timeout_ms_(timeout_ms),
+      metrics_interval_ms_(metrics_interval_ms) {
+  event_loop()->onTick([this]() { tick(); });
+  event_loop()->onRepeat(metrics_interval_ms_,
+                         [this]() { publish_metrics(); });
+}
+
+void ModbusRelayBoard::add_channel(int channel, uint16_t coil) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds Modbus channel table size", channel);
+    return;
+  }
+  int low = coil;
+  int high = coil;
+  if (num_coils_ > 0) {
+    low = std::min<int>(base_coil_, coil);
+    high = std::max<int>(base_coil_ + num_coils_ - 1, coil);
+  }
+  if (high - low >= kMaxCoils) {
+    debugE("Coil %u outside the %d-coil window at %u", coil, kMaxCoils,
+           base_coil_);
+    return;
+  }
+  // Shift existing mappings if the window grows downwards.
+  int shift = num_coils_ > 0 ? base_coil_ - low : 0;
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (registered_[i]) {
+      coil_index_[i] += shift;
+    }
+  }
+  base_coil_ = low;
+  num_coils_ = high - low + 1;
+  coil_index_[channel] = coil - base_coil_;
+  registered_.set(channel);
+}
+
+void ModbusRelayBoard::command(int channel, bool state) {
+  if (!registered_[channel]) {
+    return;
+  }
+  int index = coil_index_[channel];
+  pending_.set(index);
+  pending_value_[index] = state;
+}
+
+void ModbusRelayBoard::tick() {
+  uint32_t now = millis();
+  if (in_flight_function_ != 0) {
+    uint8_t pdu[ModbusLink::kMaxPduSize];
+    int len = link_->receive(pdu);
+    if (len > 0) {
+      handle_response(pdu, len);
+    } else if (len < 0) {
+      link_->reset();
+      finish_transaction(false);
+    } else if (now - request_sent_at_ > timeout_ms_) {
+      debugW("Modbus request 0x%02x timed out", in_flight_function_);
+      link_->reset();
+      finish_transaction(false);
+    }
+    return;
+  }
+  if (num_coils_ == 0 || now - failed_at_ < poll_interval_ms_) {
+    // Back off after a failure instead of reconnecting every tick.
+    return;
+  }
+  if (pending_.any() && read_back_once_) {
+    start_write();
+  } else if (!read_back_once_ || now - last_poll_at_ >= poll_interval_ms_) {
+    start_read();
+  }
+}
+
+void ModbusRelayBoard::start_write() {
+  // The first run of consecutive commanded coils; later runs go out on the
+  // following ticks.
+  int first = 0;
+  while (!pending_[first]) {
+    first++;
+  }
+  int last = first;
+  writing_.reset();
+  writing_.set(first);
+  while (last + 1 < num_coils_ && pending_[last + 1]) {
+    last++;
+    writing_.set(last);
+  }
+  writing_value_ = pending_value_ & writing_;
+  pending_ &= ~writing_;
+
+  uint8_t pdu[6 + kMaxCoils / 8];
+  size_t len;
+  if (first == last) {
+    pdu[0] = kWriteSingleCoil;
+    put_u16(pdu + 1, base_coil_ + first);
+    put_u16(pdu + 3, writing_value_[first] ? 0xFF00 : 0x0000);
+    len = 5;
+  } else {
+    int count = last - first + 1;
+    int num_bytes = (count + 7) / 8;
+    pdu[0] = kWriteMultipleCoils;
+    put_u16(pdu + 1, base_coil_ + first);
+    put_u16(pdu + 3, count);
+    pdu[5] = num_bytes;
+    memset(pdu + 6, 0, num_bytes);
+    for (int i = 0; i < count; i++) {
+      if (writing_value_[first + i]) {
+        pdu[6 + i / 8] |= 1 << (i % 8);
+      }
+    }
+    len = 6 + num_bytes;
+  }
+  memcpy(write_echo_, pdu + 1, sizeof(write_echo_));
+  request_sent_at_ = millis();
+  in_flight_function_ = pdu[0];
+  if (!link_->send(pdu, len)) {
+    finish_transaction(false);
+  }
+}
+
+void ModbusRelayBoard::start_read() {
+  uint8_t pdu[5];
+  pdu[0] = kReadCoils;
+  put_u16(pdu + 1, base_coil_);
+  put_u16(pdu + 3, num_coils_);
+  request_sent_at_ = millis();
+  last_poll_at_ = request_sent_at_;
+  in_flight_function_ = kReadCoils;
+  if (!link_->send(pdu, sizeof(pdu))) {
+    finish_transaction(false);
+  }
+}
+
+void ModbusRelayBoard::handle_response(const uint8_t* pdu, int len) {
+  if (pdu[0] != in_flight_function_) {
+    if (pdu[0] == (in_flight_function_ | kExceptionFlag) && len >= 2) {
+      debugW("Modbus exception %u for function 0x%02x", pdu[1],
+             in_flight_function_);
+    }
+    finish_transaction(false);
+    return;
+  }
+
+  CoilSet new_state = coil_state_;
+  if (in_flight_function_ != kReadCoils) {
+    if (len < 5 || memcmp(pdu + 1, write_echo_, sizeof(write_echo_)) != 0) {
+      debugW("Modbus write response does not match the request");
+      finish_transaction(false);
+      return;
+    }
+    new_state = (coil_state_ & ~writing_) | writing_value_;
+  } else {
+    int num_bytes = pdu[1];
+    if (len < 2 + num_bytes || num_bytes * 8 < num_coils_) {
+      finish_transaction(false);
+      return;
+    }
+    for (int i = 0; i < num_coils_; i++) {
+      new_state[i] = (pdu[2 + i / 8] >> (i % 8)) & 1;
+    }
+  }
+
+  CoilSet changed = new_state ^ coil_state_;
+  // Written coils are confirmed even if they already had the value.
+  changed |= writing_;
+  if (!read_back_once_ && in_flight_function_ == kReadCoils) {
+    // Report every channel after the first read-back.
+    changed.set();
+    read_back_once_ = true;
+  }
+  coil_state_ = new_state;
+  writing_.reset();
+  finish_transaction(true);
+
+  if (changed.none() || !state_callback_) {
+    return;
+  }
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (registered_[i] && changed[coil_index_[i]]) {
+      state_callback_(i, coil_state_[coil_index_[i]]);
+    }
+  }
+}
+
+void ModbusRelayBoard::finish_transaction(bool ok) {
+  if (ok) {
+    uint32_t latency = millis() - request_sent_at_;
+    latency_sum_ms_ += latency;
+    if (latency > latency_max_ms_) {
+      latency_max_ms_ = latency;
+    }
+    transaction_count_++;
+  } else {
+    error_count_++;
+    failed_at_ = millis();
+    if (writing_.any()) {
+      // Retry the failed write unless a newer command replaced it.
+      CoilSet retry = writing_ & ~pending_;
+      pending_ |= retry;
+      pending_value_ = (pending_value_ & ~retry) | (writing_value_ & retry);
+      writing_.reset();
+    }
+  }
+  in_flight_function_ = 0;
+}
+
+void ModbusRelayBoard::publish_metrics() {
+  if (transaction_count_ > 0) {
+    mean_latency_s_.set(latency_sum_ms_ / 1000.0 / transaction_count_);
+  } else {
+    mean_latency_s_.set(0);
+  }
+  max_latency_s_.set(latency_max_ms_ / 1000.0);
+  transactions_per_s_.set(transaction_count_ * 1000.0 / metrics_interval_ms_);
+  errors_.set(error_count_);
+  transaction_count_ = 0;
+  latency_sum_ms_ = 0;
+  latency_max_ms_ = 0;
+}
@@ -0,0 +1,186 @@
+// Modbus relay board backend
+//
+// ModbusRelayBoard maps channels to the coils of a Modbus relay board.
+// Commanded coils are written in runs of consecutive addresses, one request
+// per run: a single coil with Write Single Coil (FC05), longer runs with
+// Write Multiple Coils (FC15). A coil that was not commanded is never
+// written, so a coil switched at the board is not overwritten with a stale
+// read-back. The coil states are read back with a single Read Coils (FC1)
+// request per poll interval to feed the status LEDs; the first read-back
+// comes before any write, so every channel has reported its state first.
+// A write response must echo the request's address and value or quantity.
+//
+// Requests are non-blocking: one transaction is outstanding at a time and
+// its response is collected on later ticks. Mapped coils must lie within a
+// window of kMaxCoils consecutive addresses.
+//
+// The link layer is either Modbus TCP (MBAP header over any Arduino Client)
+// or Modbus RTU (CRC-16 framing over a serial Stream). The TCP link
+// connects from a task of its own, since Client::connect() blocks for DNS
+// and the connect timeout. Transaction latency, throughput and error counts
+// are published as diagnostics.
+
+#ifndef MODBUS_RELAY_BOARD_H_
+#define MODBUS_RELAY_BOARD_H_
+
+#include <Arduino.h>
+#include <Client.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+
+#include "channel_config.h"
+#include "sensesp/system/observablevalue.h"
+
+// Transport for Modbus PDUs (function code and data, without addressing or
+// checksums).
+class ModbusLink {
+ public:
+  static constexpr size_t kMaxPduSize = 253;
+
+  virtual ~ModbusLink() {}
+
+  // Send a request PDU. Returns false if the link is not usable.
+  virtual bool send(const uint8_t* pdu, size_t len) = 0;
+  // Collect the response to the last request. Returns the PDU length once a
+  // complete response has arrived, 0 while waiting and -1 on a framing error.
+  virtual int receive(uint8_t* pdu) = 0;
+  // Drop any partial response after a timeout.
+  virtual void reset() = 0;
+};
+
+class ModbusTcpLink : public ModbusLink {
+ public:
+  ModbusTcpLink(Client* client, const char* host, uint16_t port = 502,
+                uint8_t unit_id = 1);
+
+  // Returns false without blocking while the connection is being set up.
+  bool send(const uint8_t* pdu, size_t len) override;
+  int receive(uint8_t* pdu) override;
+  void reset() override;
+
+  bool is_connected() const {
+    return connect_state_ == ConnectState::kConnected;
+  }
+
+ private:
+  static constexpr size_t kHeaderSize = 7;
+
+  enum class ConnectState : uint8_t { kDisconnected, kConnecting, kConnected };
+
+  static void connect_task(void* arg);
+  void request_connect();
+
+  Client* client_;
+  const char* host_;
+  uint16_t port_;
+  uint8_t unit_id_;
+  uint16_t transaction_id_ = 0;
+  uint8_t buf_[kHeaderSize + kMaxPduSize];
+  size_t received_ = 0;
+
+  // The client belongs to the connect task while kConnecting.
+  std::atomic<ConnectState> connect_state_{ConnectState::kDisconnected};
+  TaskHandle_t connect_task_ = nullptr;
+};
+
+class ModbusRtuLink : public ModbusLink {
+ public:
+  ModbusRtuLink(Stream* serial, uint8_t unit_id = 1)
+      : serial_(serial), unit_id_(unit_id) {}
+
+  bool send(const uint8_t* pdu, size_t len) override;
+  int receive(uint8_t* pdu) override;
+  void reset() override;
+
+  static uint16_t crc16(const uint8_t* data, size_t len);
+
+ private:
+  // Length of the complete frame, once enough of it has arrived to tell.
+  size_t expected_length() const;
+
+  Stream* serial_;
+  uint8_t unit_id_;
+  uint8_t buf_[1 + ModbusLink::kMaxPduSize + 2];
+  size_t received_ = 0;
+};
+
+class ModbusRelayBoard {
+ public:
+  static constexpr int kMaxCoils = 64;
+
+  ModbusRelayBoard(ModbusLink* link, unsigned int poll_interval_ms = 500,
+                   unsigned int timeout_ms = 300,
+                   unsigned int metrics_interval_ms = 10000);
+
+  void add_channel(int channel, uint16_t coil);
+
+  // Command a channel's coil; written with the next write request.
+  void command(int channel, bool state);
+
+  // Called for each channel whose coil state changed on read-back, and for
+  // each channel written.
+  void set_state_callback(std::function<void(int, bool)> callback) {
+    state_callback_ = callback;
+  }
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& mean_latency_s() { return mean_latency_s_; }
+  sensesp::ObservableValue<float>& max_latency_s() { return max_latency_s_; }
+  sensesp::ObservableValue<float>& transactions_per_s() {
+    return transactions_per_s_;
+  }
+  sensesp::ObservableValue<float>& errors() { return errors_; }
+
+ private:
+  using CoilSet = std::bitset<kMaxCoils>;
+
+  void tick();
+  void start_write();
+  void start_read();
+  void handle_response(const uint8_t* pdu, int len);
+  void finish_transaction(bool ok);
+  void publish_metrics();
+
+  ModbusLink* link_;
+  const unsigned int poll_interval_ms_;
+  const unsigned int timeout_ms_;
+  const unsigned int metrics_interval_ms_;
+
+  uint8_t coil_index_[kMaxChannels] = {};
+  ChannelSet registered_;
+  uint16_t base_coil_ = 0;
+  int num_coils_ = 0;
+
+  CoilSet coil_state_;
+  CoilSet pending_;
+  CoilSet pending_value_;
+  // Coil values carried by the write request in flight.
+  CoilSet writing_;
+  CoilSet writing_value_;
+  // Address and value or quantity a write response has to echo.
+  uint8_t write_echo_[4] = {};
+
+  uint8_t in_flight_function_ = 0;
+  uint32_t request_sent_at_ = 0;
+  uint32_t last_poll_at_ = 0;
+  uint32_t failed_at_ = 0;
+  bool read_back_once_ = false;
+
+  std::function<void(int, bool)> state_callback_;
+
+  uint32_t transaction_count_ = 0;
+  uint32_t latency_sum_ms_ = 0;
+  uint32_t latency_max_ms_ = 0;
+  uint32_t error_count_ = 0;
+  sensesp::ObservableValue<float> mean_latency_s_;
+  sensesp::ObservableValue<float> max_latency_s_;
+  sensesp::ObservableValue<float> transactions_per_s_;
+  sensesp::ObservableValue<float> errors_;
+};
+
+#endif  // MODBUS_RELAY_BOARD_H_
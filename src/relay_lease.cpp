@@ -0,0 +1,88 @@
+#include "relay_lease.h"
+
+#include <ArduinoJson.h>
+
+#include "clock_sync.h"
+#include "sensesp.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+RelayLease::RelayLease(unsigned int renew_interval_ms, unsigned int ttl_factor)
+    : renew_interval_ms_(renew_interval_ms),
+      ttl_ms_(renew_interval_ms * ttl_factor) {
+  event_loop()->onRepeat(renew_interval_ms_, [this]() { renew_all(); });
+  event_loop()->onTick([this]() { flush(); });
+}
+
+void RelayLease::add_channel(int channel, SKPutRequest<bool>* put_request) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds lease table size", channel);
+    return;
+  }
+  put_requests_[channel] = put_request;
+  registered_.set(channel);
+}
+
+void RelayLease::command_sent(int channel, bool state) {
+  if (!registered_[channel] || held_[channel] == state) {
+    return;
+  }
+  held_[channel] = state;
+  dirty_.set(channel);
+}
+
+void RelayLease::hold(const ChannelSet& channels) {
+  held_ = channels & registered_;
+  dirty_ = held_;
+}
+
+String RelayLease::lease_path(const String& relay_path) {
+  const char* suffix = ".state";
+  size_t suffix_len = strlen(suffix);
+  size_t len = relay_path.length();
+  if (len > suffix_len &&
+      strcmp(relay_path.c_str() + len - suffix_len, suffix) == 0) {
+    return relay_path.substring(0, len - suffix_len) + ".lease";
+  }
+  return relay_path + ".lease";
+}
+
+void RelayLease::renew_all() { dirty_ |= held_; }
+
+void RelayLease::flush() {
+  if (dirty_.none()) {
+    return;
+  }
+  auto ws_client = sensesp_app->get_ws_client();
+  if (!ws_client->is_connected()) {
+    // Nothing to renew against; the server-side lease runs out on its own.
+    dirty_.reset();
+    return;
+  }
+
+  JsonDocument delta;
+  JsonObject update = delta["updates"].add<JsonObject>();
+  if (clock_sync != nullptr) {
+    clock_sync->add_timestamp(update);
+  }
+  JsonArray values = update["values"].to<JsonArray>();
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!dirty_[i]) {
+      continue;
+    }
+    String relay_path = put_requests_[i]->get_sk_path();
+    JsonObject entry = values.add<JsonObject>();
+    entry["path"] = lease_path(relay_path);
+    JsonObject value = entry["value"].to<JsonObject>();
+    value["path"] = relay_path;
+    // A zero time-to-live releases the lease without touching the relay.
+    value["ttl"] = held_[i] ? ttl_ms_ : 0;
+    value["holder"] = SensESPBaseApp::get_hostname();
+  }
+  dirty_.reset();
+
+  String output;
+  serializeJson(delta, output);
+  ws_client->sendTXT(output);
+}
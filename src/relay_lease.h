@@ -0,0 +1,55 @@
+// Auto-release leases for safety-critical relays
+//
+// For channels that are leased, the controller keeps a lease alive on the
+// SignalK server for as long as it has the relay commanded on. Leases are
+// published as <relay path without ".state">.lease with the relay path, a
+// time-to-live and the holder's hostname. The companion server plugin in
+// signalk-plugin/ switches the relay off when a lease is not renewed within
+// its time-to-live, so a crashed or disconnected controller cannot leave a
+// relay on forever. All leased channels are renewed in one delta per
+// interval.
+
+#ifndef RELAY_LEASE_H_
+#define RELAY_LEASE_H_
+
+#include <Arduino.h>
+
+#include <bitset>
+
+#include "channel_config.h"
+#include "sensesp/signalk/signalk_put_request.h"
+
+class RelayLease {
+ public:
+  // Leases expire on the server after ttl_factor missed renewals.
+  RelayLease(unsigned int renew_interval_ms = 5000,
+             unsigned int ttl_factor = 3);
+
+  void add_channel(int channel, sensesp::SKPutRequest<bool>* put_request);
+
+  // The controller commanded the channel's relay. Commanding it on takes the
+  // lease, commanding it off releases it.
+  void command_sent(int channel, bool state);
+
+  // Holds exactly the leases of the given channels from now on, e.g. those
+  // commanded on when this controller takes over from a standby peer. Leases
+  // dropped here are not released on the server, since another controller
+  // may be renewing them.
+  void hold(const ChannelSet& channels);
+
+  static String lease_path(const String& relay_path);
+
+ private:
+  void renew_all();
+  void flush();
+
+  const unsigned int renew_interval_ms_;
+  const unsigned int ttl_ms_;
+
+  sensesp::SKPutRequest<bool>* put_requests_[kMaxChannels] = {};
+  std::bitset<kMaxChannels> registered_;
+  std::bitset<kMaxChannels> held_;
+  std::bitset<kMaxChannels> dirty_;
+};
+
+#endif  // RELAY_LEASE_H_
@@ -0,0 +1,195 @@
+#include "standby_pair.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "sensesp.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr uint8_t kMagic[] = {'R', 'S'};
+constexpr uint8_t kProtocolVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kStateSize = 9;
+constexpr size_t kMaxFrameSize = kHeaderSize + kStateSize;
+
+void put_u32(uint8_t* buf, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    buf[i] = value >> (8 * i);
+  }
+}
+
+uint32_t get_u32(const uint8_t* buf) {
+  return buf[0] | buf[1] << 8 | buf[2] << 16 | static_cast<uint32_t>(buf[3])
+                                                   << 24;
+}
+
+}  // namespace
+
+StandbyPair::StandbyPair(ChannelStore* store, const char* peer_host,
+                         uint16_t port)
+    : store_(store),
+      peer_host_(peer_host),
+      port_(port),
+      // The low MAC bytes; the high ones are the vendor prefix.
+      node_id_(ESP.getEfuseMac() >> 16) {
+  udp_.begin(port_);
+  // Give a running active controller a chance to announce itself.
+  last_heard_ = millis();
+  role_.set(0);
+
+  event_loop()->onTick([this]() {
+    receive();
+    if (active_ && (store_->commanded_states() != sent_commanded_ ||
+                    store_->pending() != sent_pending_)) {
+      send_state();
+    }
+  });
+  event_loop()->onRepeat(kHeartbeatMs, [this]() {
+    if (active_) {
+      send_state();
+    } else {
+      check_heartbeat();
+    }
+  });
+}
+
+void StandbyPair::forward(int channel, bool state) {
+  uint8_t code = channel * 2 + (state ? 1 : 0);
+  send_frame(kCommand, &code, 1);
+}
+
+void StandbyPair::receive() {
+  uint8_t buf[kMaxFrameSize];
+  while (udp_.parsePacket() > 0) {
+    int len = udp_.read(buf, sizeof(buf));
+    if (len < static_cast<int>(kHeaderSize) || buf[0] != kMagic[0] ||
+        buf[1] != kMagic[1] || buf[2] != kProtocolVersion) {
+      continue;
+    }
+    uint32_t node_id = get_u32(buf + 4);
+    uint32_t term = get_u32(buf + 8);
+    uint32_t seq = get_u32(buf + 12);
+    if (buf[3] == kState &&
+        len >= static_cast<int>(kHeaderSize + kStateSize)) {
+      handle_state(node_id, term, seq, get_u32(buf + kHeaderSize),
+                   get_u32(buf + kHeaderSize + 4),
+                   static_cast<LinkGrade>(buf[kHeaderSize + 8]));
+    } else if (buf[3] == kCommand && len >= static_cast<int>(kHeaderSize + 1)) {
+      int channel = buf[kHeaderSize] >> 1;
+      if (active_ && channel < kMaxChannels && command_handler_) {
+        command_handler_(channel, buf[kHeaderSize] & 1);
+      }
+    }
+  }
+}
+
+void StandbyPair::handle_state(uint32_t node_id, uint32_t term, uint32_t seq,
+                               uint32_t desired, uint32_t unconfirmed,
+                               LinkGrade grade) {
+  if (active_) {
+    bool peer_wins = term > term_ || (term == term_ && node_id < node_id_);
+    if (!peer_wins) {
+      // The peer steps down when it sees our next frame.
+      return;
+    }
+    debugW("Standby pair: peer %08x is active in term %u; standing by",
+           (unsigned)node_id, (unsigned)term);
+    become_standby();
+  } else if (term < peer_term_ || (term == peer_term_ && seq <= peer_seq_)) {
+    // Reordered or from before a takeover.
+    return;
+  }
+  peer_term_ = term;
+  peer_seq_ = seq;
+  store_->replicate(ChannelSet(desired), ChannelSet(unconfirmed));
+  last_heard_ = millis();
+  heard_peer_ = true;
+  bool link_bad = grade >= LinkGrade::kPoor;
+  if (link_bad && peer_grade_ < LinkGrade::kPoor) {
+    peer_link_bad_since_ = last_heard_;
+  }
+  peer_grade_ = grade;
+}
+
+void StandbyPair::send_state() {
+  uint8_t payload[kStateSize];
+  sent_commanded_ = store_->commanded_states();
+  sent_pending_ = store_->pending();
+  put_u32(payload, sent_commanded_.to_ulong());
+  put_u32(payload + 4, sent_pending_.to_ulong());
+  payload[8] = static_cast<uint8_t>(
+      link_quality_ != nullptr ? link_quality_->grade() : LinkGrade::kGood);
+  send_frame(kState, payload, sizeof(payload));
+}
+
+void StandbyPair::send_frame(FrameType type, const uint8_t* payload,
+                             size_t len) {
+  uint8_t buf[kMaxFrameSize];
+  buf[0] = kMagic[0];
+  buf[1] = kMagic[1];
+  buf[2] = kProtocolVersion;
+  buf[3] = type;
+  put_u32(buf + 4, node_id_);
+  put_u32(buf + 8, term_);
+  put_u32(buf + 12, ++seq_);
+  memcpy(buf + kHeaderSize, payload, len);
+  udp_.beginPacket(peer_host_, port_);
+  udp_.write(buf, kHeaderSize + len);
+  udp_.endPacket();
+}
+
+void StandbyPair::check_heartbeat() {
+  uint32_t now = millis();
+  if (now - last_heard_ >= kTakeoverMs) {
+    become_active();
+    return;
+  }
+  if (link_quality_ != nullptr && peer_grade_ >= LinkGrade::kPoor &&
+      link_quality_->grade() == LinkGrade::kGood &&
+      now - peer_link_bad_since_ >= kLinkFailoverMs) {
+    debugW("Standby pair: active peer's link is poor; taking over");
+    become_active();
+  }
+}
+
+void StandbyPair::become_active() {
+  uint32_t silence_ms = millis() - last_heard_;
+  active_ = true;
+  term_ = std::max(term_, peer_term_) + 1;
+  seq_ = 0;
+  role_.set(1);
+  if (role_handler_) {
+    role_handler_(true);
+  }
+  if (!heard_peer_) {
+    debugI("Standby pair: no active peer; taking the active role");
+    send_state();
+    return;
+  }
+  debugW("Standby pair: last heartbeat %u ms ago; taking over in term %u",
+         (unsigned)silence_ms, (unsigned)term_);
+  takeover_time_s_.set(silence_ms / 1000.0);
+  peer_grade_ = LinkGrade::kGood;
+
+  // Resend what the old active controller did not get confirmed. Pending
+  // commands this controller has seen confirmed are done.
+  ChannelSet resend = store_->pending() & ~store_->settled();
+  store_->replicate(store_->commanded_states(), resend);
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (resend[i] && command_handler_) {
+      command_handler_(i, store_->commanded(i));
+    }
+  }
+  send_state();
+}
+
+void StandbyPair::become_standby() {
+  active_ = false;
+  role_.set(0);
+  if (role_handler_) {
+    role_handler_(false);
+  }
+}
@@ -0,0 +1,118 @@
+// Active/standby pairing of two controllers
+//
+// Two controllers with the same channel table can back each other up. One
+// is active and sends the commands; the other is standby and forwards its
+// button and panel commands to the active one. The active controller sends
+// the commanded and pending bits of its channel store to the standby as a
+// small UDP frame on every change and as a heartbeat. Role changes are
+// reported so that the new active controller can take over the relay leases
+// for the channels that are commanded on. Pending channels are
+// those whose command the server has not confirmed yet, i.e. the ones still
+// waiting in the transmit queue or in flight.
+//
+// When heartbeats stop for kTakeoverMs, the standby takes over. It resends
+// only the commands its own listeners have not seen confirmed, so commands
+// the old active controller got through are not repeated. Every takeover
+// starts a new term; if both controllers end up active, the one with the
+// older term, or with equal terms the higher node id, steps down.
+//
+// The active controller also reports its link grade. A standby with a good
+// link takes over when the active one's link has been poor or down for
+// kLinkFailoverMs.
+//
+// The time from the last heartbeat to a takeover is published as a
+// diagnostic, along with the current role.
+
+#ifndef STANDBY_PAIR_H_
+#define STANDBY_PAIR_H_
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#include <cstdint>
+#include <functional>
+
+#include "channel_config.h"
+#include "channel_store.h"
+#include "link_quality.h"
+#include "sensesp/system/observablevalue.h"
+
+class StandbyPair {
+ public:
+  static constexpr uint16_t kDefaultPort = 4210;
+  static constexpr uint32_t kHeartbeatMs = 200;
+  static constexpr uint32_t kTakeoverMs = 1000;
+  static constexpr uint32_t kLinkFailoverMs = 5000;
+
+  StandbyPair(ChannelStore* store, const char* peer_host,
+              uint16_t port = kDefaultPort);
+
+  bool is_active() const { return active_; }
+
+  void set_link_quality(LinkQuality* link_quality) {
+    link_quality_ = link_quality;
+  }
+
+  // Applies commands on the active controller: forwarded ones and, after a
+  // takeover, the unconfirmed ones.
+  void set_command_handler(std::function<void(int, bool)> handler) {
+    command_handler_ = handler;
+  }
+
+  // Called with true when this controller becomes active and with false when
+  // it steps down, before any commands are resent.
+  void set_role_handler(std::function<void(bool)> handler) {
+    role_handler_ = handler;
+  }
+
+  // Send a command from the standby to the active controller.
+  void forward(int channel, bool state);
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& takeover_time_s() {
+    return takeover_time_s_;
+  }
+  sensesp::ObservableValue<float>& role() { return role_; }
+
+ private:
+  enum FrameType : uint8_t { kState = 0, kCommand = 1 };
+
+  void receive();
+  void handle_state(uint32_t node_id, uint32_t term, uint32_t seq,
+                    uint32_t desired, uint32_t unconfirmed, LinkGrade grade);
+  void send_state();
+  void send_frame(FrameType type, const uint8_t* payload, size_t len);
+  void check_heartbeat();
+  void become_active();
+  void become_standby();
+
+  ChannelStore* store_;
+  WiFiUDP udp_;
+  const char* peer_host_;
+  const uint16_t port_;
+  const uint32_t node_id_;
+
+  bool active_ = false;
+  uint32_t term_ = 0;
+  uint32_t seq_ = 0;
+  uint32_t peer_seq_ = 0;
+  uint32_t peer_term_ = 0;
+  uint32_t last_heard_ = 0;
+  bool heard_peer_ = false;
+  LinkGrade peer_grade_ = LinkGrade::kGood;
+  uint32_t peer_link_bad_since_ = 0;
+
+  // Store bits last sent to the standby.
+  ChannelSet sent_commanded_;
+  ChannelSet sent_pending_;
+
+  std::function<void(int, bool)> command_handler_;
+  std::function<void(bool)> role_handler_;
+  LinkQuality* link_quality_ = nullptr;
+
+  sensesp::ObservableValue<float> takeover_time_s_;
+  sensesp::ObservableValue<float> role_;
+};
+
+#endif  // STANDBY_PAIR_H_
@@ -0,0 +1,179 @@
+#include "state_api.h"
+
+#include <esp_idf_version.h>
+#include <esp_random.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "sensesp.h"
+#include "sensesp/net/http_server.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+namespace {
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+constexpr bool kCanHoldRequests = true;
+#else
+constexpr bool kCanHoldRequests = false;
+#endif
+
+// Enough for the header and "\"31\":false," for every channel.
+constexpr size_t kResponseSize = 96 + kMaxChannels * 12;
+
+uint32_t query_value(const char* query, const char* key, uint32_t fallback) {
+  char value[12];
+  if (httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+    return fallback;
+  }
+  return strtoul(value, nullptr, 10);
+}
+
+}  // namespace
+
+StateApi::StateApi(ChannelStore* store)
+    : store_(store), boot_id_(esp_random()) {
+  incoming_waiters_ = xQueueCreate(kMaxWaiters, sizeof(Waiter));
+
+  auto handler = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/relays/api/state",
+      [this](httpd_req_t* req) { return handle_request(req); });
+  sensesp_app->get_http_server()->add_handler(handler);
+
+  event_loop()->onTick([this]() { tick(); });
+}
+
+void StateApi::tick() {
+  if (!synced_ || store_->version() != version_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    store_->snapshot(&snapshot_);
+    version_ = snapshot_.version;
+    synced_ = true;
+  }
+  serve_waiters();
+}
+
+size_t StateApi::format_since(uint32_t since, char* buf, size_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t version = snapshot_.version;
+  // A client from before a reboot may be ahead of the counter.
+  bool full = since == 0 || since > version;
+
+  ChannelSet changed;
+  if (full) {
+    changed = snapshot_.registered;
+  } else {
+    for (int i = 0; i < kMaxChannels; i++) {
+      if (snapshot_.versions[i] > since) {
+        changed.set(i);
+      }
+    }
+  }
+
+  size_t pos = 0;
+  int written = snprintf(buf, len,
+                         "{\"boot\":%u,\"version\":%u,\"full\":%s,"
+                         "\"states\":{",
+                         (unsigned)boot_id_, (unsigned)version,
+                         full ? "true" : "false");
+  if (written < 0 || static_cast<size_t>(written) >= len) {
+    return 0;
+  }
+  pos = written;
+  const char* separator = "";
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!changed[i]) {
+      continue;
+    }
+    const char* value = !snapshot_.known[i] ? "null"
+                        : snapshot_.state[i] ? "true"
+                                             : "false";
+    written = snprintf(buf + pos, len - pos, "%s\"%d\":%s", separator, i,
+                       value);
+    if (written < 0 || static_cast<size_t>(written) >= len - pos) {
+      return 0;
+    }
+    pos += written;
+    separator = ",";
+  }
+  if (len - pos < 3) {
+    return 0;
+  }
+  buf[pos++] = '}';
+  buf[pos++] = '}';
+  buf[pos] = '\0';
+  return pos;
+}
+
+esp_err_t StateApi::respond(httpd_req_t* req, uint32_t since) {
+  char buf[kResponseSize];
+  size_t len = format_since(since, buf, sizeof(buf));
+  if (len == 0) {
+    return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                               "Response too large");
+  }
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, buf, len);
+}
+
+esp_err_t StateApi::handle_request(httpd_req_t* req) {
+  uint32_t since = 0;
+  uint32_t wait_ms = 0;
+  char query[48];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    since = query_value(query, "since", 0);
+    wait_ms = query_value(query, "wait", 0);
+  }
+  if (!kCanHoldRequests || wait_ms == 0 || since == 0 || since != version_) {
+    return respond(req, since);
+  }
+  if (num_waiting_.fetch_add(1) >= kMaxWaiters) {
+    num_waiting_--;
+    return respond(req, since);
+  }
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+  // Detach the request from the server task and let the event loop answer
+  // it once something changes.
+  Waiter waiter;
+  if (httpd_req_async_handler_begin(req, &waiter.req) != ESP_OK) {
+    num_waiting_--;
+    return respond(req, since);
+  }
+  waiter.since = since;
+  waiter.deadline = millis() + std::min(wait_ms, kMaxWaitMs);
+  // The queue holds kMaxWaiters entries, so this cannot fail.
+  xQueueSend(incoming_waiters_, &waiter, 0);
+#endif
+  return ESP_OK;
+}
+
+void StateApi::serve_waiters() {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+  Waiter waiter;
+  while (xQueueReceive(incoming_waiters_, &waiter, 0) == pdTRUE) {
+    waiters_[num_waiters_++] = waiter;
+  }
+  if (num_waiters_ == 0) {
+    return;
+  }
+  uint32_t now = millis();
+  uint32_t version = version_;
+  for (int i = 0; i < num_waiters_;) {
+    Waiter& w = waiters_[i];
+    if (w.since == version && static_cast<int32_t>(now - w.deadline) < 0) {
+      i++;
+      continue;
+    }
+    respond(w.req, w.since);
+    httpd_req_async_handler_complete(w.req);
+    waiters_[i] = waiters_[--num_waiters_];
+    num_waiting_--;
+  }
+#endif
+}
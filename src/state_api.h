@@ -0,0 +1,74 @@
+// Versioned channel state snapshots over HTTP
+//
+// GET /relays/api/state?since=N returns the current version of the channel
+// store and the states of the channels that changed after version N, or of
+// all channels if N is 0. The store stamps every channel with the version
+// of its last change, so any N can be answered without a change log.
+// Responses are formatted straight into a fixed buffer; no JSON document is
+// built per request. The response also carries a boot id, so that clients
+// notice when the version counter restarted.
+//
+// Requests are answered from a copy of the store taken in the event loop
+// whenever its version changes, so the HTTP server task never reads the
+// live store.
+//
+// With wait=<ms>, a request that has nothing new is held until a change
+// arrives or the wait expires (long polling). Holding a request needs the
+// asynchronous request API of ESP-IDF 5.1 or later; on older frameworks the
+// request is answered immediately. Held requests keep a socket of the
+// SensESP HTTP server open, so only a few are held at a time.
+
+#ifndef STATE_API_H_
+#define STATE_API_H_
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "channel_store.h"
+
+class StateApi {
+ public:
+  static constexpr uint32_t kMaxWaitMs = 30000;
+  static constexpr int kMaxWaiters = 2;
+
+  StateApi(ChannelStore* store);
+
+  // Format the response for a client at version `since`. Returns the length
+  // written, or 0 if the buffer was too small.
+  size_t format_since(uint32_t since, char* buf, size_t len);
+
+ private:
+  struct Waiter {
+    httpd_req_t* req;
+    uint32_t since;
+    uint32_t deadline;
+  };
+
+  esp_err_t handle_request(httpd_req_t* req);
+  esp_err_t respond(httpd_req_t* req, uint32_t since);
+  void tick();
+  void serve_waiters();
+
+  ChannelStore* store_;
+  const uint32_t boot_id_;
+
+  // Written by the event loop, read by the HTTP server task.
+  std::mutex mutex_;
+  ChannelStore::Snapshot snapshot_;
+  std::atomic<uint32_t> version_{0};
+  bool synced_ = false;
+
+  // Long-poll requests handed over from the HTTP server task.
+  QueueHandle_t incoming_waiters_ = nullptr;
+  std::atomic<int> num_waiting_{0};
+  Waiter waiters_[kMaxWaiters] = {};
+  int num_waiters_ = 0;
+};
+
+#endif  // STATE_API_H_
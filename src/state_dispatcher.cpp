@@ -0,0 +1,95 @@
+#include "state_dispatcher.h"
+
+#include <Arduino.h>
+
+#include "sensesp.h"
+
+using namespace sensesp;
+
+StateDispatcher::StateDispatcher(int budget_per_tick,
+                                 unsigned int input_guard_ms,
+                                 unsigned int max_input_hold_ms,
+                                 unsigned int metrics_interval_ms)
+    : budget_per_tick_(budget_per_tick),
+      input_guard_ms_(input_guard_ms),
+      max_input_hold_ms_(max_input_hold_ms) {
+  event_loop()->onTick([this]() { dispatch(); });
+  event_loop()->onRepeat(metrics_interval_ms, [this]() {
+    coalesced_.set(coalesced_count_);
+    deferred_.set(deferred_count_);
+  });
+}
+
+void StateDispatcher::add_channel(int channel, ChannelPriority priority,
+                                  Handler handler) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds dispatcher size", channel);
+    return;
+  }
+  handlers_[channel] = handler;
+  registered_.set(channel);
+  class_mask_[static_cast<int>(priority)].set(channel);
+}
+
+void StateDispatcher::post(int channel, bool state) {
+  if (!registered_[channel]) {
+    return;
+  }
+  if (pending_[channel]) {
+    coalesced_count_++;
+  }
+  pending_.set(channel);
+  values_[channel] = state;
+  posted_at_[channel] = millis();
+}
+
+void StateDispatcher::input_event() {
+  uint32_t now = millis();
+  if (!input_guard_) {
+    if (static_cast<int32_t>(now - rearm_at_) < 0) {
+      return;
+    }
+    guard_started_ = now;
+  }
+  input_guard_ = true;
+  input_at_ = now;
+}
+
+void StateDispatcher::dispatch() {
+  if (pending_.none()) {
+    return;
+  }
+  if (input_guard_) {
+    uint32_t now = millis();
+    bool settled = now - input_at_ >= input_guard_ms_;
+    if (!settled && now - guard_started_ < max_input_hold_ms_) {
+      return;
+    }
+    input_guard_ = false;
+    if (!settled) {
+      // Still chattering; let deltas through for a guard period.
+      rearm_at_ = now + input_guard_ms_;
+    }
+  }
+
+  int budget = budget_per_tick_;
+  for (int p = 0; p < kNumPriorities && budget > 0; p++) {
+    ChannelSet ready = pending_ & class_mask_[p];
+    if (ready.none()) {
+      continue;
+    }
+    int start = cursor_[p];
+    for (int n = 0; n < kMaxChannels && budget > 0; n++) {
+      int i = (start + n) % kMaxChannels;
+      if (!ready[i]) {
+        continue;
+      }
+      pending_.reset(i);
+      budget--;
+      handlers_[i](values_[i]);
+      // Resume after the channel just handled.
+      cursor_[p] = (i + 1) % kMaxChannels;
+    }
+  }
+  deferred_count_ += pending_.count();
+}
@@ -0,0 +1,80 @@
+// Priority-ordered processing of incoming relay states
+//
+// SignalK value listeners post into the dispatcher instead of acting on a
+// delta right away. Once per tick, the dispatcher hands the latest posted
+// state of each channel to that channel's handler, critical channels first,
+// so a burst of deltas never delays the channels that matter most. Multiple
+// deltas for one channel collapse into the latest value until it is handled.
+//
+// At most budget_per_tick handlers run per tick; channels left over keep
+// their latest value and are handled on later ticks, round-robin within a
+// priority class. After a button changes, dispatching pauses for
+// input_guard_ms so that the button is serviced first. A server flooding
+// the subscribed paths therefore cannot starve the buttons. A chattering
+// input cannot starve the server either: the pause lasts at most
+// max_input_hold_ms from the first edge, and a pause cut short that way is
+// followed by input_guard_ms of dispatching before input can pause it
+// again. The number of
+// coalesced deltas and of channels deferred by the budget are published as
+// diagnostics.
+
+#ifndef STATE_DISPATCHER_H_
+#define STATE_DISPATCHER_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "channel_config.h"
+#include "sensesp/system/observablevalue.h"
+
+class StateDispatcher {
+ public:
+  using Handler = std::function<void(bool)>;
+
+  StateDispatcher(int budget_per_tick = 4, unsigned int input_guard_ms = 60,
+                  unsigned int max_input_hold_ms = 200,
+                  unsigned int metrics_interval_ms = 10000);
+
+  void add_channel(int channel, ChannelPriority priority, Handler handler);
+
+  // Record a state reported by the server; handled on a following tick.
+  void post(int channel, bool state);
+  // When the state being handled was posted, for handlers that time it
+  // from its arrival rather than from the dispatch.
+  uint32_t posted_at(int channel) const { return posted_at_[channel]; }
+
+  // A button changed; let it be handled before more deltas.
+  void input_event();
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& coalesced() { return coalesced_; }
+  sensesp::ObservableValue<float>& deferred() { return deferred_; }
+
+ private:
+  void dispatch();
+
+  const int budget_per_tick_;
+  const unsigned int input_guard_ms_;
+  const unsigned int max_input_hold_ms_;
+
+  Handler handlers_[kMaxChannels];
+  ChannelSet registered_;
+  ChannelSet class_mask_[kNumPriorities];
+  ChannelSet pending_;
+  ChannelSet values_;
+  uint32_t posted_at_[kMaxChannels] = {};
+  int cursor_[kNumPriorities] = {};
+
+  bool input_guard_ = false;
+  uint32_t input_at_ = 0;
+  uint32_t guard_started_ = 0;
+  // Input does not pause dispatching before this time.
+  uint32_t rearm_at_ = 0;
+
+  uint32_t coalesced_count_ = 0;
+  uint32_t deferred_count_ = 0;
+  sensesp::ObservableValue<float> coalesced_;
+  sensesp::ObservableValue<float> deferred_;
+};
+
+#endif  // STATE_DISPATCHER_H_
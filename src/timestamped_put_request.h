@@ -0,0 +1,22 @@
+// SKPutRequest that stamps each PUT with the corrected server time
+
+#ifndef TIMESTAMPED_PUT_REQUEST_H_
+#define TIMESTAMPED_PUT_REQUEST_H_
+
+#include "clock_sync.h"
+#include "sensesp/signalk/signalk_put_request.h"
+
+template <typename T>
+class TimestampedPutRequest : public sensesp::SKPutRequest<T> {
+ public:
+  using sensesp::SKPutRequest<T>::SKPutRequest;
+
+  void set_put_value(JsonObject& put_data) override {
+    sensesp::SKPutRequest<T>::set_put_value(put_data);
+    if (clock_sync != nullptr) {
+      clock_sync->add_timestamp(put_data);
+    }
+  }
+};
+
+#endif  // TIMESTAMPED_PUT_REQUEST_H_
@@ -0,0 +1,49 @@
+#include "touch_detector.h"
+
+TouchDetector::TouchDetector(std::function<uint16_t()> read,
+                             std::function<void(uint16_t)> set_threshold)
+    : read_(read), set_threshold_(set_threshold) {}
+
+TouchDetector::Event TouchDetector::update(bool triggered, uint32_t now) {
+  if (triggered) {
+    if (!touched_ && baseline_ != 0) {
+      touched_ = true;
+      touched_at_ = now;
+      return Event::kTouched;
+    }
+    return Event::kNone;
+  }
+  if (touched_ && read_() >= release_level_) {
+    touched_ = false;
+    return Event::kReleased;
+  }
+  return Event::kNone;
+}
+
+TouchDetector::Event TouchDetector::track_drift(uint32_t now) {
+  uint16_t value = read_();
+  if (baseline_ == 0) {
+    set_baseline(value);
+    return Event::kNone;
+  }
+  if (touched_) {
+    if (now - touched_at_ < kStuckMs) {
+      return Event::kNone;
+    }
+    set_baseline(value);
+    touched_ = false;
+    return Event::kReleased;
+  }
+  // Follow slow drift with a time constant of eight updates. Touches that
+  // did not reach the threshold nudge the baseline down only slightly.
+  set_baseline(baseline_ + (static_cast<int>(value) - baseline_) / 8);
+  return Event::kNone;
+}
+
+void TouchDetector::set_baseline(uint16_t baseline) {
+  baseline_ = baseline;
+  threshold_ = baseline * (1 - kTouchRatio);
+  // Release halfway between the threshold and the baseline.
+  release_level_ = baseline * (1 - kTouchRatio / 2);
+  set_threshold_(threshold_);
+}
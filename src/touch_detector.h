@@ -0,0 +1,56 @@
+// Touch detection logic for one capacitive pad
+//
+// TouchDetector is the hardware-independent part of TouchInput: the
+// baseline, the touch threshold derived from it, the release level with
+// hysteresis, drift tracking and stuck-touch recovery. It reads the pad and
+// sets its threshold through the functions it is given, so recorded touch
+// traces can be replayed through it off the device.
+//
+// The baseline is 0 until the first drift update calibrates the pad; touches
+// are ignored until then.
+
+#ifndef TOUCH_DETECTOR_H_
+#define TOUCH_DETECTOR_H_
+
+#include <cstdint>
+#include <functional>
+
+class TouchDetector {
+ public:
+  enum class Event : uint8_t { kNone, kTouched, kReleased };
+
+  // A touch lowers the reading by at least this share of the baseline.
+  static constexpr float kTouchRatio = 0.2;
+  // A touch held this long is taken as the new baseline.
+  static constexpr uint32_t kStuckMs = 30000;
+
+  TouchDetector(std::function<uint16_t()> read,
+                std::function<void(uint16_t)> set_threshold);
+
+  // Once per tick. triggered tells whether the pad's threshold interrupt
+  // fired since the last call. Reads the pad only while it is touched.
+  Event update(bool triggered, uint32_t now);
+  // Periodically, to follow drift. Reports a release when a stuck touch is
+  // recalibrated away.
+  Event track_drift(uint32_t now);
+
+  bool calibrated() const { return baseline_ != 0; }
+  bool touched() const { return touched_; }
+  uint16_t baseline() const { return baseline_; }
+  uint16_t threshold() const { return threshold_; }
+  uint16_t release_level() const { return release_level_; }
+
+ private:
+  void set_baseline(uint16_t baseline);
+
+  std::function<uint16_t()> read_;
+  std::function<void(uint16_t)> set_threshold_;
+
+  uint16_t baseline_ = 0;
+  uint16_t threshold_ = 0;
+  uint16_t release_level_ = 0;
+  bool touched_ = false;
+  uint32_t touched_at_ = 0;
+};
+
+#endif  // TOUCH_DETECTOR_H_
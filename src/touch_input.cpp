@@ -0,0 +1,98 @@
+#include "touch_input.h"
+
+#include "sensesp.h"
+
+#if CONFIG_IDF_TARGET_ESP32
+#include "driver/touch_pad.h"
+#endif
+
+using namespace sensesp;
+
+volatile uint32_t TouchInput::triggered_ = 0;
+bool TouchInput::initialized_ = false;
+
+#if CONFIG_IDF_TARGET_ESP32
+
+TouchInput::TouchInput(int pin)
+    : pad_(digitalPinToTouchChannel(pin)),
+      detector_(
+          [this]() {
+            uint16_t value = 0;
+            touch_pad_read_filtered(static_cast<touch_pad_t>(pad_), &value);
+            return value;
+          },
+          [this](uint16_t threshold) {
+            touch_pad_set_thresh(static_cast<touch_pad_t>(pad_), threshold);
+          }) {
+  if (pad_ < 0) {
+    debugE("GPIO %d is not a touch pad", pin);
+    return;
+  }
+  if (!initialized_) {
+    touch_pad_init();
+    touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+    touch_pad_set_voltage(TOUCH_HVOLT_2V7, TOUCH_LVOLT_0V5,
+                          TOUCH_HVOLT_ATTEN_1V);
+    touch_pad_set_trigger_mode(TOUCH_TRIGGER_BELOW);
+    touch_pad_filter_start(kFilterPeriodMs);
+    touch_pad_isr_register(isr, nullptr);
+    touch_pad_intr_enable();
+    initialized_ = true;
+  }
+  // A threshold of 0 never triggers; the first drift update calibrates the
+  // pad once the filter has settled.
+  touch_pad_config(static_cast<touch_pad_t>(pad_), 0);
+  // Released until touched.
+  emit(true);
+
+  event_loop()->onTick([this]() { tick(); });
+  event_loop()->onRepeat(kDriftIntervalMs, [this]() { track_drift(); });
+}
+
+void IRAM_ATTR TouchInput::isr(void* arg) {
+  triggered_ |= touch_pad_get_status();
+  touch_pad_clear_status();
+}
+
+#else
+
+TouchInput::TouchInput(int pin) : pad_(-1), detector_(nullptr, nullptr) {
+  debugE("No touch pads on this chip; GPIO %d ignored", pin);
+}
+
+void TouchInput::isr(void* arg) {}
+
+#endif
+
+void TouchInput::tick() {
+  const uint32_t bit = 1UL << pad_;
+  bool triggered = triggered_ & bit;
+  if (triggered) {
+    // Not atomic with the ISR, which may set other bits meanwhile; losing
+    // one is harmless since it fires again on the next measurement.
+    triggered_ &= ~bit;
+  }
+  emit_event(detector_.update(triggered, millis()));
+}
+
+void TouchInput::track_drift() {
+  bool calibrated = detector_.calibrated();
+  TouchDetector::Event event = detector_.track_drift(millis());
+  if (!calibrated && detector_.calibrated()) {
+    debugD("Touch pad %d calibrated at %u", pad_, detector_.baseline());
+  }
+  if (event == TouchDetector::Event::kReleased) {
+    debugW("Touch pad %d held for %u s; recalibrating", pad_,
+           TouchDetector::kStuckMs / 1000);
+  }
+  emit_event(event);
+}
+
+void TouchInput::emit_event(TouchDetector::Event event) {
+  // Touched reads as a pressed button with a pull-up: false.
+  if (event == TouchDetector::Event::kTouched) {
+    emit(false);
+  } else if (event == TouchDetector::Event::kReleased) {
+    emit(true);
+  }
+}
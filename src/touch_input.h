@@ -0,0 +1,61 @@
+// Capacitive touch button on an ESP32 touch pad
+//
+// TouchInput turns a touch pad into a button for sealed panels without
+// mechanical switches. Like DigitalInputChange with INPUT_PULLUP it emits
+// false while the pad is touched and true when it is released, so it feeds
+// the same debounce and toggle pipeline.
+//
+// The touch peripheral measures all pads in the background. The original
+// ESP32 (touch v1) has no hardware filter: touch_pad_filter_start() runs a
+// software IIR filter on a FreeRTOS timer every kFilterPeriodMs, and the
+// threshold interrupt compares the raw readings. A touch pulls a raw reading
+// below the pad's threshold and raises the interrupt, which the event loop
+// picks up on the next tick; the event loop does not read idle pads. Only a
+// touched pad is read, using the filtered reading, to detect its release
+// with some hysteresis. A single noisy raw reading can raise the interrupt
+// too; the filtered reading ends such a blip on the next tick and the
+// debounce downstream drops it.
+//
+// The untouched reading drifts with temperature, humidity and water on the
+// panel. Every kDriftIntervalMs the baseline of each idle pad follows its
+// filtered reading and the threshold is moved with it. A touch held longer
+// than TouchDetector::kStuckMs, such as a wet cloth over the pad, is taken
+// as the new baseline and released. The detection logic lives in
+// TouchDetector.
+//
+// Touch pads exist on the original ESP32 only; see board_profile.h.
+
+#ifndef TOUCH_INPUT_H_
+#define TOUCH_INPUT_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "sensesp/system/valueproducer.h"
+#include "touch_detector.h"
+
+class TouchInput : public sensesp::ValueProducer<bool> {
+ public:
+  // Period of the software filter's timer.
+  static constexpr uint32_t kFilterPeriodMs = 10;
+  static constexpr unsigned int kDriftIntervalMs = 1000;
+
+  explicit TouchInput(int pin);
+
+ private:
+  static void IRAM_ATTR isr(void* arg);
+
+  void tick();
+  void track_drift();
+  void emit_event(TouchDetector::Event event);
+
+  const int pad_;
+  TouchDetector detector_;
+
+  // Pads that crossed their threshold since the last tick, set by the ISR.
+  static volatile uint32_t triggered_;
+  static bool initialized_;
+};
+
+#endif  // TOUCH_INPUT_H_
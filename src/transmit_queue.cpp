@@ -0,0 +1,178 @@
+#include "transmit_queue.h"
+
+#include "sensesp.h"
+#include "sensesp_app.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr int kCritical = static_cast<int>(ChannelPriority::kCritical);
+
+}  // namespace
+
+TransmitQueue::TransmitQueue(ChannelStore* store, int max_in_flight,
+                             int max_retries, unsigned int metrics_interval_ms)
+    : store_(store), max_in_flight_(max_in_flight), max_retries_(max_retries) {
+  event_loop()->onTick([this]() { drain(); });
+  event_loop()->onRepeat(50, [this]() { expire_in_flight(); });
+  event_loop()->onRepeat(metrics_interval_ms,
+                         [this]() { publish_metrics(); });
+}
+
+void TransmitQueue::add_channel(int channel, SKPutRequest<bool>* put_request,
+                                ChannelPriority priority) {
+  if (channel < 0 || channel >= kMaxChannels) {
+    debugE("Channel %d exceeds transmit queue size", channel);
+    return;
+  }
+  put_requests_[channel] = put_request;
+  priority_[channel] = static_cast<uint8_t>(priority);
+  class_mask_[priority_[channel]].set(channel);
+  registered_.set(channel);
+}
+
+void TransmitQueue::enqueue(int channel) {
+  if (!registered_[channel]) {
+    return;
+  }
+  if (pending_[channel]) {
+    superseded_count_++;
+  } else {
+    enqueued_at_[channel] = millis();
+  }
+  retries_[channel] = 0;
+  if (in_flight_[channel] &&
+      in_flight_value_[channel] == store_->commanded(channel)) {
+    // The value on its way already is the one wanted; nothing to send.
+    pending_.reset(channel);
+    return;
+  }
+  pending_.set(channel);
+}
+
+void TransmitQueue::state_received(int channel, bool state) {
+  if (in_flight_[channel] && in_flight_value_[channel] == state) {
+    in_flight_.reset(channel);
+    if (link_quality_ != nullptr) {
+      link_quality_->add_delivery(true);
+      if (!timed_out_[channel]) {
+        uint32_t received_at = dispatcher_ != nullptr
+                                   ? dispatcher_->posted_at(channel)
+                                   : millis();
+        link_quality_->add_rtt_sample(received_at - sent_at_[channel]);
+      }
+    }
+    timed_out_.reset(channel);
+  }
+}
+
+void TransmitQueue::drain() {
+  if (pending_.none()) {
+    return;
+  }
+  auto ws_client = sensesp_app->get_ws_client();
+  if (!ws_client->is_connected()) {
+    // Hold the latest values until the connection is back.
+    return;
+  }
+
+  uint32_t now = millis();
+  uint32_t batch_window_ms =
+      link_quality_ != nullptr ? link_quality_->batch_window_ms() : 0;
+  int num_in_flight = in_flight_.count();
+  for (int p = 0; p < kNumPriorities; p++) {
+    // Lower classes leave one slot free for critical channels, and are
+    // held for the batching window.
+    int limit = p == kCritical ? max_in_flight_ : max_in_flight_ - 1;
+    num_in_flight = drain_class(p, num_in_flight, limit, now,
+                                p == kCritical ? 0 : batch_window_ms);
+  }
+  if (compact_ != nullptr && compact_->active()) {
+    compact_->flush();
+  }
+}
+
+int TransmitQueue::drain_class(int priority, int num_in_flight, int limit,
+                               uint32_t now, uint32_t batch_window_ms) {
+  ChannelSet ready = pending_ & class_mask_[priority] & ~in_flight_;
+  if (ready.none()) {
+    return num_in_flight;
+  }
+  ClassMetrics& metrics = class_metrics_[priority];
+  int start = cursor_[priority];
+  for (int n = 0; n < kMaxChannels && num_in_flight < limit; n++) {
+    int i = (start + n) % kMaxChannels;
+    if (!ready[i] || now - enqueued_at_[i] < batch_window_ms) {
+      continue;
+    }
+    bool state = store_->commanded(i);
+    pending_.reset(i);
+    in_flight_.set(i);
+    in_flight_value_[i] = state;
+    sent_at_[i] = now;
+    num_in_flight++;
+
+    uint32_t latency = now - enqueued_at_[i];
+    metrics.latency_sum_ms += latency;
+    if (latency > metrics.latency_max_ms) {
+      metrics.latency_max_ms = latency;
+    }
+    metrics.sent_count++;
+
+    if (compact_ != nullptr && compact_->active()) {
+      compact_->add(i, state);
+    } else {
+      put_requests_[i]->set(state);
+    }
+    // Resume after the channel just served.
+    cursor_[priority] = (i + 1) % kMaxChannels;
+  }
+  return num_in_flight;
+}
+
+void TransmitQueue::expire_in_flight() {
+  if (in_flight_.none()) {
+    return;
+  }
+  uint32_t now = millis();
+  for (int i = 0; i < kMaxChannels; i++) {
+    if (!in_flight_[i]) {
+      continue;
+    }
+    auto priority = static_cast<ChannelPriority>(priority_[i]);
+    uint32_t timeout_ms = link_quality_ != nullptr
+                              ? link_quality_->ack_timeout_ms(priority)
+                              : kAckTimeoutMs[priority_[i]];
+    if (now - sent_at_[i] <= timeout_ms) {
+      continue;
+    }
+    in_flight_.reset(i);
+    timed_out_.set(i);
+    if (link_quality_ != nullptr) {
+      link_quality_->add_delivery(false);
+    }
+    if (!pending_[i] && retries_[i] < max_retries_) {
+      // Unconfirmed and not superseded: send the commanded value again.
+      retries_[i]++;
+      pending_.set(i);
+      enqueued_at_[i] = now;
+    }
+  }
+}
+
+void TransmitQueue::publish_metrics() {
+  for (ClassMetrics& metrics : class_metrics_) {
+    if (metrics.sent_count > 0) {
+      metrics.mean_latency_s.set(metrics.latency_sum_ms / 1000.0 /
+                                 metrics.sent_count);
+    } else {
+      metrics.mean_latency_s.set(0);
+    }
+    metrics.max_latency_s.set(metrics.latency_max_ms / 1000.0);
+    metrics.sent_count = 0;
+    metrics.latency_sum_ms = 0;
+    metrics.latency_max_ms = 0;
+  }
+  superseded_.set(superseded_count_);
+}
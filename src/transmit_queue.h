@@ -0,0 +1,136 @@
+// Transmit scheduler for relay PUTs
+//
+// TransmitQueue holds at most one pending value per channel. A newer command
+// for the same channel replaces the pending one, so after congestion only
+// the latest state is sent instead of the whole backlog. A channel has at
+// most one PUT in flight at a time, and the number of PUTs in flight across
+// all channels is limited; a PUT leaves flight when the listener reports the
+// commanded value, or is retried after its priority class's ack timeout.
+// The websocket client does not expose its send buffer, so the in-flight
+// window is what stands in for socket writability.
+//
+// Pending channels are served by priority class, critical first, and
+// round-robin within a class. One in-flight slot is reserved for critical
+// channels so lower classes cannot fill the window.
+//
+// On a slow link, non-critical commands are held for a short batching
+// window so that more of them go out together, and ack timeouts stretch
+// with the measured round trip; see LinkQuality.
+//
+// The value sent for a channel is always its commanded state in the channel
+// store. The queue keeps only transport state the store has no use for:
+// which channels wait for a send slot and since when (the batching window
+// and queue latency start at the first unsent command, and a retry restarts
+// them), and which value is on the wire since when, for ack timeouts,
+// retries and round-trip samples. A store-pending command can be in neither
+// set, e.g. after its retries ran out.
+//
+// Round trips run from the send to the arrival of the confirming delta, not
+// to its dispatch. Following Karn's rule, a channel whose PUT timed out gives
+// no round-trip sample until a confirmation arrives: it could answer any of
+// the PUTs sent for the value.
+//
+// Queue latency (enqueue to send) per priority class and the number of
+// superseded commands are published as diagnostics.
+
+#ifndef TRANSMIT_QUEUE_H_
+#define TRANSMIT_QUEUE_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "channel_config.h"
+#include "channel_store.h"
+#include "compact_commands.h"
+#include "link_quality.h"
+#include "sensesp/signalk/signalk_put_request.h"
+#include "sensesp/system/observablevalue.h"
+#include "state_dispatcher.h"
+
+class TransmitQueue {
+ public:
+  TransmitQueue(ChannelStore* store, int max_in_flight = 4, int max_retries = 2,
+                unsigned int metrics_interval_ms = 10000);
+
+  void add_channel(int channel, sensesp::SKPutRequest<bool>* put_request,
+                   ChannelPriority priority = ChannelPriority::kNormal);
+
+  // Queue the channel's commanded state, replacing any value still pending
+  // for it. The store must already hold the command.
+  void enqueue(int channel);
+  // The SignalK server reported a new value for the channel.
+  void state_received(int channel, bool state);
+
+  // Send commands batched in the compact encoding while the server plugin
+  // supports it.
+  void set_compact_commands(CompactCommands* compact) { compact_ = compact; }
+
+  // Take ack timeouts and the batching window from the link estimate, and
+  // feed it confirmation round trips and lost PUTs.
+  void set_link_quality(LinkQuality* link_quality) {
+    link_quality_ = link_quality;
+  }
+
+  // Time round trips to the arrival of the confirming delta at the
+  // dispatcher that state_received() is called from.
+  void set_state_dispatcher(StateDispatcher* dispatcher) {
+    dispatcher_ = dispatcher;
+  }
+
+  int depth() const { return pending_.count(); }
+
+  // Diagnostics, for connecting to SignalK outputs.
+  sensesp::ObservableValue<float>& mean_latency_s(ChannelPriority priority) {
+    return class_metrics_[static_cast<int>(priority)].mean_latency_s;
+  }
+  sensesp::ObservableValue<float>& max_latency_s(ChannelPriority priority) {
+    return class_metrics_[static_cast<int>(priority)].max_latency_s;
+  }
+  sensesp::ObservableValue<float>& superseded() { return superseded_; }
+
+ private:
+  struct ClassMetrics {
+    uint32_t sent_count = 0;
+    uint32_t latency_sum_ms = 0;
+    uint32_t latency_max_ms = 0;
+    sensesp::ObservableValue<float> mean_latency_s;
+    sensesp::ObservableValue<float> max_latency_s;
+  };
+
+  void drain();
+  // Send pending channels of one class; returns the updated in-flight count.
+  int drain_class(int priority, int num_in_flight, int limit, uint32_t now,
+                  uint32_t batch_window_ms);
+  void expire_in_flight();
+  void publish_metrics();
+
+  ChannelStore* store_;
+  const int max_in_flight_;
+  const int max_retries_;
+
+  sensesp::SKPutRequest<bool>* put_requests_[kMaxChannels] = {};
+  uint32_t enqueued_at_[kMaxChannels] = {};
+  uint32_t sent_at_[kMaxChannels] = {};
+  uint8_t priority_[kMaxChannels] = {};
+  uint8_t retries_[kMaxChannels] = {};
+
+  ChannelSet registered_;
+  ChannelSet class_mask_[kNumPriorities];
+  ChannelSet pending_;
+  ChannelSet in_flight_;
+  ChannelSet in_flight_value_;
+  // Channels with a PUT that timed out since their last confirmation.
+  ChannelSet timed_out_;
+  int cursor_[kNumPriorities] = {};
+
+  CompactCommands* compact_ = nullptr;
+  LinkQuality* link_quality_ = nullptr;
+  StateDispatcher* dispatcher_ = nullptr;
+
+  ClassMetrics class_metrics_[kNumPriorities];
+  uint32_t superseded_count_ = 0;
+  sensesp::ObservableValue<float> superseded_;
+};
+
+#endif  // TRANSMIT_QUEUE_H_
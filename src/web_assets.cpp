@@ -0,0 +1,100 @@
+#include "web_assets.h"
+
+#include <strings.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "sensesp/net/http_server.h"
+#include "sensesp_app.h"
+#include "web_assets_autogen.h"
+
+using namespace sensesp;
+
+namespace {
+
+// Weight of the coding that starts at coding and ends before end, from its
+// q parameter; 1 if it has none.
+float weight(const char* coding, const char* end) {
+  const char* param =
+      static_cast<const char*>(memchr(coding, ';', end - coding));
+  if (param == nullptr) {
+    return 1;
+  }
+  param++;
+  param += strspn(param, " \t");
+  if (strncasecmp(param, "q=", 2) != 0) {
+    return 1;
+  }
+  return strtof(param + 2, nullptr);
+}
+
+// Whether an Accept-Encoding value allows gzip. A gzip entry decides by its
+// weight; otherwise a "*" entry does.
+bool allows_gzip(const char* accept_encoding) {
+  float gzip = -1;
+  float any = 0;
+  const char* coding = accept_encoding;
+  while (*coding != '\0') {
+    coding += strspn(coding, " \t,");
+    const char* end = coding + strcspn(coding, ",");
+    size_t name_len = strcspn(coding, " \t;,");
+    if (name_len == 4 && strncasecmp(coding, "gzip", 4) == 0) {
+      gzip = weight(coding, end);
+    } else if (name_len == 1 && *coding == '*') {
+      any = weight(coding, end);
+    }
+    coding = end;
+  }
+  return gzip >= 0 ? gzip > 0 : any > 0;
+}
+
+}  // namespace
+
+WebAssetServer::WebAssetServer() {
+  auto http_server = sensesp_app->get_http_server();
+  for (const WebAsset& asset : kWebAssets) {
+    const WebAsset* entry = &asset;
+    auto handler = std::make_shared<HTTPRequestHandler>(
+        1 << HTTP_GET, entry->uri,
+        [entry](httpd_req_t* req) { return serve(req, *entry); });
+    http_server->add_handler(handler);
+  }
+}
+
+esp_err_t WebAssetServer::serve(httpd_req_t* req, const WebAsset& asset) {
+  bool is_page = strcmp(asset.content_type, "text/html") == 0;
+  httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+  // Without the header, any coding is acceptable. A longer value than fits
+  // is checked as far as it was read.
+  char accept_encoding[96];
+  esp_err_t err = httpd_req_get_hdr_value_str(
+      req, "Accept-Encoding", accept_encoding, sizeof(accept_encoding));
+  if ((err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) &&
+      !allows_gzip(accept_encoding)) {
+    // Only the compressed copy is stored.
+    httpd_resp_set_status(req, "406 Not Acceptable");
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_sendstr(req, "Only gzip encoding is available\n");
+  }
+
+  httpd_resp_set_hdr(req, "ETag", asset.etag);
+  httpd_resp_set_hdr(req, "Cache-Control",
+                     is_page ? "no-cache" : "public, max-age=604800");
+
+  char if_none_match[40];
+  if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match,
+                                  sizeof(if_none_match)) == ESP_OK &&
+      strcmp(if_none_match, asset.etag) == 0) {
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, nullptr, 0);
+  }
+
+  httpd_resp_set_type(req, asset.content_type);
+  httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+  // Flash is memory mapped; the body is sent without a RAM copy.
+  return httpd_resp_send(req, reinterpret_cast<const char*>(asset.data),
+                         asset.size);
+}
@@ -0,0 +1,36 @@
+// Static web UI assets served from flash
+//
+// The files in web/ are compressed at build time by
+// tools/embed_web_assets.py and compiled in as constant arrays. They are
+// sent as stored, gzip-encoded, straight from flash without copying. There
+// is no uncompressed copy, so a client whose Accept-Encoding rules out gzip
+// gets a 406 response; browsers all accept gzip. Every asset has a strong
+// ETag; a request whose If-None-Match matches gets an empty 304 response.
+// Pages are revalidated on each visit, other assets are cached by the
+// browser for a week.
+
+#ifndef WEB_ASSETS_H_
+#define WEB_ASSETS_H_
+
+#include <esp_http_server.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct WebAsset {
+  const char* uri;
+  const char* content_type;
+  const char* etag;
+  const uint8_t* data;
+  size_t size;
+};
+
+class WebAssetServer {
+ public:
+  // Register handlers for all embedded assets with the SensESP HTTP server.
+  WebAssetServer();
+
+  static esp_err_t serve(httpd_req_t* req, const WebAsset& asset);
+};
+
+#endif  // WEB_ASSETS_H_
@@ -0,0 +1,114 @@
+// Generated by tools/embed_web_assets.py from web/. Do not edit.
+
+#ifndef WEB_ASSETS_AUTOGEN_H_
+#define WEB_ASSETS_AUTOGEN_H_
+
+#include "web_assets.h"
+
+static const uint8_t kWebAsset_index_html[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x45, 0x50, 0xb1, 0x56, 0xc3, 0x30,
+    0x0c, 0xdc, 0xfb, 0x15, 0xc6, 0x33, 0xa9, 0x5f, 0x37, 0x06, 0x3b, 0x0b, 0x65, 0x86, 0xc7, 0x63,
+    0x61, 0x14, 0x8e, 0x52, 0x0b, 0x1c, 0xb9, 0xcf, 0x56, 0xdb, 0x97, 0xbf, 0xc7, 0x4e, 0x52, 0x98,
+    0x64, 0x9d, 0x4e, 0xa7, 0x3b, 0xdb, 0x87, 0xe3, 0xeb, 0xf3, 0xc7, 0xe7, 0xdb, 0x8b, 0x0a, 0x32,
+    0xc5, 0x7e, 0x67, 0x5b, 0x51, 0x11, 0xf8, 0xe4, 0x34, 0xb2, 0x6e, 0x00, 0xc2, 0x50, 0xcb, 0x84,
+    0x02, 0xca, 0x07, 0xc8, 0x05, 0xc5, 0xe9, 0x8b, 0x8c, 0xdd, 0x93, 0xbe, 0xc3, 0x0c, 0x13, 0x3a,
+    0x7d, 0x25, 0xbc, 0x9d, 0x53, 0x16, 0xad, 0x7c, 0x62, 0x41, 0xae, 0xb4, 0x1b, 0x0d, 0x12, 0xdc,
+    0x80, 0x57, 0xf2, 0xd8, 0x2d, 0xcd, 0xa3, 0x22, 0x26, 0x21, 0x88, 0x5d, 0xf1, 0x10, 0xd1, 0x1d,
+    0x9a, 0x88, 0x90, 0x44, 0xec, 0xdf, 0x31, 0xc2, 0x5c, 0xac, 0x59, 0xbb, 0x9d, 0x8d, 0xc4, 0x3f,
+    0x2a, 0x63, 0x74, 0xba, 0xc8, 0x1c, 0xb1, 0x04, 0xc4, 0xaa, 0x1d, 0x32, 0x8e, 0x4e, 0x9b, 0xbc,
+    0x90, 0xcd, 0x32, 0xd9, 0xfb, 0x52, 0x9a, 0x8c, 0xd9, 0xac, 0x7e, 0xa5, 0x61, 0xde, 0x8c, 0x63,
+    0xee, 0x6d, 0x38, 0xfc, 0x49, 0xd7, 0xe7, 0xca, 0xaa, 0x78, 0xf5, 0x0e, 0xc4, 0x8a, 0x06, 0xa7,
+    0x6b, 0x2c, 0x66, 0x8c, 0x55, 0xc4, 0x9a, 0x06, 0xd6, 0xd9, 0x98, 0x92, 0xb4, 0x65, 0xb8, 0x1f,
+    0xd4, 0xfd, 0x71, 0x89, 0xd1, 0xc2, 0x8d, 0x74, 0xba, 0x64, 0x10, 0x4a, 0x6c, 0x0d, 0xd4, 0x9d,
+    0x8d, 0xbc, 0xb3, 0xc5, 0x67, 0x3a, 0x8b, 0x2a, 0xd9, 0xff, 0x5b, 0x5c, 0xcb, 0xfe, 0x7b, 0x51,
+    0x5f, 0x09, 0xcd, 0xeb, 0x66, 0xd2, 0xac, 0xdf, 0xfe, 0x0b, 0xa8, 0x5a, 0x7f, 0x64, 0x87, 0x01,
+    0x00, 0x00,
+};
+
+static const uint8_t kWebAsset_relays_js[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x55, 0x4d, 0x6f, 0xdb, 0x30,
+    0x0c, 0xbd, 0xe7, 0x57, 0xf0, 0x54, 0xcb, 0x6b, 0xe0, 0xa4, 0x3d, 0x0d, 0x09, 0xb2, 0x62, 0x2b,
+    0x72, 0xe8, 0x50, 0xb4, 0x45, 0xb3, 0x6e, 0x87, 0xa2, 0x07, 0xc5, 0x66, 0x62, 0xa3, 0x8a, 0x64,
+    0x48, 0x72, 0xb3, 0x60, 0xc8, 0x7f, 0x1f, 0xf5, 0x61, 0xc7, 0x49, 0xdb, 0x4b, 0x12, 0x89, 0xe4,
+    0xe3, 0x23, 0xf9, 0xc4, 0x8c, 0x46, 0xf0, 0xbb, 0xd2, 0xb6, 0xe1, 0x02, 0x72, 0x25, 0xad, 0x56,
+    0x02, 0x6a, 0x2e, 0x51, 0x4c, 0xc0, 0x94, 0x6a, 0x6b, 0x00, 0xdf, 0x50, 0xef, 0x20, 0x2f, 0xb9,
+    0xa4, 0x4b, 0xe0, 0x06, 0x38, 0x2c, 0x1b, 0x6b, 0x95, 0x04, 0x2e, 0x0b, 0x30, 0x28, 0x0b, 0x33,
+    0x18, 0x8d, 0x28, 0x76, 0xb3, 0xa1, 0x0b, 0x03, 0x8a, 0xfc, 0xc9, 0x67, 0x8b, 0x4b, 0xa3, 0xf2,
+    0x57, 0xb4, 0x60, 0x15, 0xd8, 0x12, 0x5b, 0x70, 0x41, 0x56, 0x56, 0x2b, 0x6d, 0xe1, 0xeb, 0x45,
+    0x9a, 0xc1, 0x77, 0xb8, 0xb2, 0xea, 0x15, 0xe5, 0x0c, 0x08, 0x90, 0xdc, 0x1c, 0x54, 0xcd, 0xd7,
+    0x08, 0x4f, 0x8f, 0xb7, 0x50, 0x19, 0xfa, 0x6d, 0x0c, 0x16, 0xde, 0x18, 0x60, 0x3a, 0xdc, 0x6c,
+    0xc0, 0x56, 0x8d, 0xcc, 0x6d, 0x45, 0x36, 0x96, 0xc2, 0xbf, 0x01, 0xb8, 0x14, 0xc6, 0xe5, 0x23,
+    0x3c, 0x98, 0x81, 0xc4, 0xad, 0x43, 0x59, 0x20, 0xd7, 0x79, 0xf9, 0xc0, 0x35, 0xdf, 0x18, 0x26,
+    0x54, 0xce, 0x5d, 0x44, 0x66, 0xfc, 0x6d, 0x9a, 0xad, 0xd1, 0xb2, 0xc4, 0x47, 0x24, 0xe9, 0xb4,
+    0x83, 0x70, 0x5c, 0x79, 0x25, 0x89, 0xea, 0x0c, 0x0a, 0x95, 0x37, 0x1b, 0x94, 0xd6, 0xb9, 0xce,
+    0x05, 0xba, 0x9f, 0x3f, 0x76, 0x37, 0x05, 0x4b, 0x62, 0x4b, 0x4c, 0x3f, 0x30, 0x74, 0xc6, 0x50,
+    0xd8, 0xf3, 0x8b, 0xbb, 0x15, 0x54, 0x7f, 0x6c, 0x03, 0x11, 0x6a, 0x84, 0x98, 0x0e, 0xe8, 0xb6,
+    0xe3, 0xad, 0xa9, 0x7b, 0xa8, 0x99, 0xe4, 0x1b, 0x34, 0xa1, 0x04, 0x38, 0xe4, 0xce, 0x2c, 0xfe,
+    0xb5, 0xd7, 0x74, 0xa2, 0x8c, 0x14, 0x9d, 0x24, 0x53, 0x6f, 0x8f, 0x29, 0x32, 0x81, 0x72, 0x6d,
+    0x4b, 0x32, 0x8c, 0xc3, 0xbd, 0x07, 0xc9, 0x56, 0x4a, 0xcf, 0x79, 0x5e, 0x32, 0x8f, 0x39, 0x6c,
+    0xc7, 0x96, 0xc2, 0xec, 0x5b, 0x84, 0x07, 0xa8, 0x56, 0xe0, 0xad, 0x30, 0x9b, 0x05, 0x4e, 0x69,
+    0x67, 0x3a, 0xa0, 0xd7, 0x8d, 0x29, 0x99, 0x37, 0x4e, 0x3b, 0x9b, 0x46, 0xdb, 0x68, 0xd9, 0x9e,
+    0xf7, 0xf1, 0xbb, 0x5f, 0x78, 0xbf, 0x5d, 0xb9, 0x46, 0x6e, 0x31, 0x76, 0x8c, 0x25, 0xc1, 0x21,
+    0xe9, 0xe0, 0xc2, 0x39, 0xcb, 0x05, 0x0d, 0xf8, 0xce, 0xb3, 0x81, 0xb6, 0xa3, 0xc9, 0x89, 0xcf,
+    0x71, 0x1f, 0x1c, 0xf5, 0x13, 0x07, 0x5e, 0x14, 0xf3, 0x37, 0xb2, 0xde, 0x56, 0x86, 0x9c, 0xa8,
+    0xa1, 0x49, 0x2e, 0xaa, 0xfc, 0x35, 0x19, 0x3a, 0x61, 0xf4, 0x2a, 0x6f, 0xc9, 0x7a, 0xa2, 0x7d,
+    0x02, 0x2e, 0x30, 0x8b, 0x8d, 0x37, 0x2c, 0xe9, 0xf3, 0x0c, 0xfd, 0x8a, 0x33, 0x3c, 0x3b, 0x8b,
+    0xd3, 0xcc, 0xa8, 0xb8, 0x62, 0xb7, 0xb0, 0x54, 0xa1, 0x6f, 0xe3, 0x1f, 0x5c, 0x2e, 0x82, 0xe1,
+    0xfe, 0x61, 0x7e, 0xd7, 0x6f, 0x28, 0xb4, 0x11, 0xee, 0xa5, 0xb0, 0x85, 0xd5, 0x95, 0x5c, 0xb3,
+    0xf6, 0x35, 0x7d, 0x81, 0x4b, 0x38, 0x07, 0x46, 0x7c, 0xae, 0x60, 0x0c, 0x13, 0xb8, 0x48, 0xd3,
+    0x5e, 0x62, 0x78, 0xcf, 0x91, 0x2a, 0x65, 0x49, 0x4d, 0x48, 0x84, 0xd2, 0xe7, 0xd8, 0x0e, 0x63,
+    0xdf, 0xdd, 0x1d, 0x64, 0xc4, 0x6b, 0x17, 0x70, 0x5d, 0x56, 0xa2, 0x60, 0x01, 0xf0, 0x64, 0x08,
+    0x71, 0xda, 0x47, 0xb6, 0x00, 0xb4, 0x3f, 0x52, 0x6b, 0x53, 0x17, 0x54, 0x2f, 0x33, 0xae, 0xea,
+    0x4e, 0xae, 0xe1, 0x74, 0xd0, 0x9d, 0x3f, 0x7f, 0x2c, 0xbc, 0x13, 0xa5, 0xc4, 0xe4, 0xcf, 0xd1,
+    0xf5, 0x65, 0xda, 0xd3, 0x67, 0xe4, 0xf2, 0x4e, 0x98, 0xbd, 0x56, 0x58, 0xb5, 0x5e, 0x0b, 0xf4,
+    0xc3, 0x1a, 0x06, 0x16, 0x7e, 0x12, 0x56, 0x37, 0xd8, 0x6b, 0xcc, 0xbb, 0x30, 0x8d, 0x1b, 0xda,
+    0x50, 0x1f, 0x34, 0x71, 0xff, 0x69, 0xdd, 0xc4, 0x5b, 0x62, 0x6e, 0x59, 0x4b, 0xc7, 0x3d, 0xea,
+    0x46, 0x0b, 0xa7, 0xd8, 0xad, 0x99, 0x8c, 0x46, 0x09, 0xcd, 0xb0, 0x5b, 0x2c, 0xa5, 0x32, 0xd6,
+    0xbf, 0xae, 0x73, 0x48, 0x26, 0x5f, 0x2f, 0x46, 0x1a, 0x05, 0xdf, 0x99, 0xd1, 0xd6, 0x44, 0x55,
+    0xbb, 0xea, 0xfc, 0xbe, 0x39, 0x14, 0xe7, 0xb0, 0xce, 0x09, 0x2c, 0x6e, 0x42, 0x07, 0x87, 0x32,
+    0x57, 0x05, 0x3e, 0x3d, 0xde, 0x5c, 0xab, 0x4d, 0xad, 0xa4, 0x7b, 0x41, 0x21, 0x28, 0x4e, 0x67,
+    0x70, 0x10, 0x56, 0xdc, 0x74, 0x9d, 0x02, 0x19, 0xc1, 0x45, 0xb7, 0xa8, 0x3c, 0x25, 0x69, 0x33,
+    0x18, 0xb7, 0x54, 0x67, 0xc0, 0xd0, 0x3d, 0x94, 0x0f, 0xc6, 0x72, 0x70, 0xf9, 0xb9, 0xb8, 0xbf,
+    0xcb, 0x6a, 0xae, 0x0d, 0x06, 0xe7, 0x8c, 0xa6, 0xce, 0xd3, 0xfe, 0x74, 0xa2, 0x6f, 0x76, 0xb4,
+    0xb7, 0xc2, 0x86, 0xf0, 0xfb, 0xec, 0xd8, 0x7e, 0xba, 0x30, 0xa2, 0x8c, 0x5a, 0xa7, 0x28, 0xa7,
+    0x58, 0xd8, 0x09, 0xf1, 0x5c, 0x28, 0xe3, 0x69, 0x1f, 0x31, 0xee, 0x76, 0xcc, 0x52, 0x15, 0xbb,
+    0xd3, 0xd7, 0xa1, 0x56, 0x2b, 0x41, 0xba, 0x3f, 0x0c, 0xd6, 0xa0, 0xfd, 0x55, 0x6d, 0x50, 0x35,
+    0x96, 0xc5, 0x49, 0x0e, 0xe1, 0x72, 0x3c, 0x1e, 0x7f, 0x92, 0x52, 0xd5, 0xfe, 0xdf, 0x23, 0x64,
+    0xfc, 0x2c, 0x53, 0xab, 0xa2, 0xa3, 0x64, 0x5e, 0x35, 0x9d, 0x58, 0xa6, 0x83, 0x7d, 0xea, 0x3e,
+    0xff, 0x03, 0x09, 0xc1, 0x27, 0x1a, 0x60, 0x07, 0x00, 0x00,
+};
+
+static const uint8_t kWebAsset_style_css[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x52, 0xdb, 0x8e, 0xdb, 0x20,
+    0x10, 0x7d, 0xcf, 0x57, 0x8c, 0x94, 0x97, 0x5d, 0x29, 0x58, 0x6b, 0x27, 0xe9, 0xa6, 0xce, 0xd7,
+    0x8c, 0x61, 0xb0, 0x47, 0xc5, 0x60, 0x01, 0x96, 0xd6, 0xad, 0xfa, 0xef, 0x1d, 0x9c, 0x4b, 0xe3,
+    0x4a, 0x7d, 0x31, 0x62, 0x38, 0x87, 0x73, 0xc1, 0x5d, 0x30, 0x0b, 0xfc, 0xda, 0x01, 0x8c, 0x18,
+    0x7b, 0xf6, 0x2d, 0x7c, 0x5c, 0x65, 0x63, 0x83, 0xcf, 0xca, 0xe2, 0xc8, 0x6e, 0x69, 0x21, 0x2d,
+    0x29, 0xd3, 0xa8, 0x66, 0x3e, 0x40, 0x42, 0x9f, 0x54, 0xa2, 0xc8, 0xb6, 0xa0, 0x3a, 0xd4, 0x3f,
+    0xfa, 0x18, 0x66, 0x6f, 0x5a, 0xd8, 0xd7, 0x1f, 0xf5, 0xb7, 0x5a, 0x97, 0xb1, 0x0e, 0x2e, 0x44,
+    0x99, 0xd0, 0x85, 0xc8, 0x36, 0xd7, 0xdd, 0xef, 0xdd, 0x40, 0x68, 0x28, 0x1e, 0xe4, 0xda, 0x90,
+    0x29, 0xae, 0x72, 0x13, 0x1a, 0xc3, 0xbe, 0x17, 0xbd, 0xea, 0xf3, 0x1c, 0x69, 0x84, 0x5a, 0x3e,
+    0x2b, 0xb6, 0xfe, 0x8f, 0x9d, 0xc4, 0x3f, 0xa9, 0x85, 0xba, 0x6a, 0xce, 0x77, 0x24, 0xae, 0xc0,
+    0x87, 0xda, 0x45, 0xeb, 0x8b, 0xb5, 0x65, 0xbe, 0xd7, 0x03, 0x7a, 0x4f, 0x2e, 0xad, 0xe7, 0x86,
+    0xd3, 0xe4, 0x50, 0x62, 0xf4, 0x91, 0x4d, 0xb9, 0xac, 0xac, 0x4a, 0x02, 0xc9, 0x34, 0x93, 0x12,
+    0xfa, 0x3c, 0xfa, 0xd4, 0x42, 0xa4, 0x89, 0x30, 0xbf, 0xe1, 0x9c, 0x83, 0xb2, 0xec, 0xdc, 0x01,
+    0x46, 0xf6, 0x23, 0x7e, 0xbd, 0x7d, 0x17, 0xb9, 0x03, 0xd4, 0x36, 0xbe, 0xbf, 0xaf, 0x74, 0x9c,
+    0x9e, 0xa6, 0xaf, 0x9b, 0x20, 0xcf, 0x08, 0xd5, 0xdd, 0xc0, 0x2d, 0x08, 0x7b, 0x35, 0x10, 0xf7,
+    0x43, 0x6e, 0xe1, 0xc1, 0xe9, 0x42, 0x94, 0x3e, 0x5a, 0x68, 0xa6, 0x2f, 0x48, 0xc1, 0xb1, 0x81,
+    0xfd, 0xf1, 0x78, 0xaa, 0x4f, 0xe6, 0xef, 0xa1, 0x8a, 0x68, 0x78, 0x4e, 0x45, 0xea, 0xc9, 0xda,
+    0xd4, 0xdd, 0x35, 0xe7, 0x86, 0x5e, 0xea, 0x66, 0x3f, 0xc8, 0xbb, 0xe4, 0x7f, 0xeb, 0xba, 0x73,
+    0x73, 0x98, 0xf5, 0xa0, 0x50, 0x67, 0x0e, 0x52, 0xea, 0x88, 0x9e, 0xa7, 0x59, 0xf2, 0xcb, 0xee,
+    0xd5, 0x70, 0x15, 0xfc, 0xea, 0x79, 0xa3, 0xd4, 0xd8, 0x4f, 0x3c, 0x76, 0x2f, 0xce, 0x1e, 0x8d,
+    0x9f, 0x6c, 0x67, 0xcf, 0x76, 0xc3, 0x9f, 0xc8, 0x97, 0x32, 0x6e, 0x97, 0xdc, 0xd0, 0x29, 0x2f,
+    0x4e, 0x8c, 0x18, 0x4c, 0x03, 0x99, 0x02, 0xee, 0xe4, 0x8f, 0xab, 0x82, 0xb5, 0x8e, 0x3d, 0xc1,
+    0xf6, 0xad, 0xc2, 0x84, 0x9a, 0xf3, 0x52, 0x42, 0x9f, 0x0a, 0xf4, 0x0f, 0xa2, 0x0e, 0x07, 0xc2,
+    0x9d, 0x02, 0x00, 0x00,
+};
+
+static const WebAsset kWebAssets[] = {
+    {"/relays/", "text/html", "\"79f12659c611ea31\"", kWebAsset_index_html, sizeof(kWebAsset_index_html)},
+    {"/relays/relays.js", "application/javascript", "\"015d212435f334f7\"", kWebAsset_relays_js, sizeof(kWebAsset_relays_js)},
+    {"/relays/style.css", "text/css", "\"3e704ec99e55570a\"", kWebAsset_style_css, sizeof(kWebAsset_style_css)},
+};
+
+#endif  // WEB_ASSETS_AUTOGEN_H_
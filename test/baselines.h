@@ -0,0 +1,57 @@
+// Stored baselines for the native tests
+//
+// Measured on a 64-bit host with the mocks in test/mocks; sizes differ on
+// the ESP32, where a ChannelSet takes four bytes instead of eight, but grow
+// and shrink with it. A test fails when its measurement exceeds the
+// baseline by more than kTolerancePercent. When a change makes a value
+// better, lower the baseline with it; when it makes one worse on purpose,
+// raise the baseline in the same commit and say why.
+
+#ifndef BASELINES_H_
+#define BASELINES_H_
+
+#include <cstdint>
+
+namespace baseline {
+
+constexpr uint32_t kTolerancePercent = 10;
+
+// Largest measurement that still passes against the given baseline.
+constexpr uint32_t limit(uint32_t baseline) {
+  return baseline + baseline * kTolerancePercent / 100;
+}
+
+// RAM per channel: the channel store, the pipeline modules' tables divided
+// by kMaxChannels, and the heap that wiring up one channel as main.cpp does
+// takes, not counting SensESP's own objects.
+constexpr uint32_t kChannelStoreBytes = 752;
+constexpr uint32_t kStaticBytesPerChannel = 174;
+constexpr uint32_t kSetupHeapBytesPerChannel = 176;
+
+// Heap allocations per relay event: a command, its PUT and the confirmed
+// state coming back. Events must not touch the heap.
+constexpr uint32_t kAllocationsPerEvent = 0;
+
+// Simulated time from a button toggle to the confirmed state with a server
+// that answers after kServerRttMs, on an idle link.
+constexpr uint32_t kServerRttMs = 20;
+constexpr uint32_t kToggleLatencyMs = 22;
+// The worst toggle latency of a critical channel while low-priority
+// channels saturate the in-flight window.
+constexpr uint32_t kCriticalLatencyUnderLoadMs = 22;
+
+// The replayed touch trace: the longest time from a finger landing on the
+// pad to the debounced press, and raw touches while only noise was on the
+// pad, per hour of trace.
+constexpr uint32_t kTouchDetectionLatencyMs = 95;
+constexpr uint32_t kTouchFalseTriggersPerHour = 48;
+
+}  // namespace baseline
+
+// Fail if actual exceeds the baseline beyond the tolerance.
+#define TEST_ASSERT_WITHIN_BASELINE(baseline_value, actual) \
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(                 \
+      baseline::limit(baseline_value), (actual),            \
+      "regressed past " #baseline_value)
+
+#endif  // BASELINES_H_
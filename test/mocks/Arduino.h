@@ -0,0 +1,183 @@
+// Arduino core stand-in for the native tests
+//
+// Provides the parts of the Arduino API the tested modules use: a simulated
+// millisecond clock that only moves when a test advances it, String, the
+// Print and Stream interfaces and the ESP object. String keeps its text in a
+// std::string and has the members ArduinoJson needs to read and write it.
+
+#ifndef MOCK_ARDUINO_H_
+#define MOCK_ARDUINO_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define IRAM_ATTR
+
+namespace mock {
+
+// Simulated time since boot; 64 bits so that tests can run past the wrap of
+// millis().
+inline uint64_t& now_ms() {
+  static uint64_t now = 0;
+  return now;
+}
+
+}  // namespace mock
+
+inline uint32_t millis() { return static_cast<uint32_t>(mock::now_ms()); }
+inline uint32_t micros() {
+  return static_cast<uint32_t>(mock::now_ms() * 1000);
+}
+inline void delay(uint32_t ms) { mock::now_ms() += ms; }
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : s_(s != nullptr ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  explicit String(int value) : s_(std::to_string(value)) {}
+  explicit String(unsigned int value) : s_(std::to_string(value)) {}
+  explicit String(long value) : s_(std::to_string(value)) {}
+  explicit String(unsigned long value) : s_(std::to_string(value)) {}
+  explicit String(float value, unsigned int decimals = 2)
+      : String(static_cast<double>(value), decimals) {}
+  explicit String(double value, unsigned int decimals = 2) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(decimals), value);
+    s_ = buf;
+  }
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return s_.length(); }
+  bool isEmpty() const { return s_.empty(); }
+  void reserve(unsigned int size) { s_.reserve(size); }
+
+  char operator[](unsigned int index) const { return s_[index]; }
+  char& operator[](unsigned int index) { return s_[index]; }
+
+  bool concat(const char* s) {
+    s_ += s;
+    return true;
+  }
+  bool concat(const String& s) {
+    s_ += s.s_;
+    return true;
+  }
+  String& operator+=(const String& s) {
+    s_ += s.s_;
+    return *this;
+  }
+  String& operator+=(const char* s) {
+    s_ += s;
+    return *this;
+  }
+  String& operator+=(char c) {
+    s_ += c;
+    return *this;
+  }
+
+  // Print-style writes, used by serializers.
+  size_t write(uint8_t c) {
+    s_ += static_cast<char>(c);
+    return 1;
+  }
+  size_t write(const uint8_t* buf, size_t size) {
+    s_.append(reinterpret_cast<const char*>(buf), size);
+    return size;
+  }
+
+  String substring(unsigned int from) const { return s_.substr(from); }
+  String substring(unsigned int from, unsigned int to) const {
+    return s_.substr(from, to - from);
+  }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = s_.find(c, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+  }
+  int indexOf(const char* s, unsigned int from = 0) const {
+    size_t pos = s_.find(s, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+  }
+  int lastIndexOf(char c) const {
+    size_t pos = s_.rfind(c);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+  }
+  bool startsWith(const String& prefix) const {
+    return s_.compare(0, prefix.s_.size(), prefix.s_) == 0;
+  }
+  bool endsWith(const String& suffix) const {
+    return s_.size() >= suffix.s_.size() &&
+           s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(),
+                      suffix.s_) == 0;
+  }
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+  std::string::const_iterator begin() const { return s_.begin(); }
+  std::string::const_iterator end() const { return s_.end(); }
+
+  friend bool operator==(const String& a, const String& b) {
+    return a.s_ == b.s_;
+  }
+  friend bool operator!=(const String& a, const String& b) {
+    return a.s_ != b.s_;
+  }
+  friend bool operator<(const String& a, const String& b) {
+    return a.s_ < b.s_;
+  }
+
+ private:
+  std::string s_;
+};
+
+// The result type of String concatenation in the Arduino core; ArduinoJson
+// adapts it.
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String& a, const String& b) {
+  String result = a;
+  result += b;
+  return result;
+}
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t size) {
+    size_t written = 0;
+    while (written < size && write(buf[written]) == 1) {
+      written++;
+    }
+    return written;
+  }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+  virtual void flush() {}
+};
+
+class EspClass {
+ public:
+  uint64_t getEfuseMac() const { return efuse_mac; }
+  uint32_t getFreeHeap() const { return 200000; }
+
+  // Set by tests that run several simulated controllers.
+  uint64_t efuse_mac = 0x0000AABBCCDDEEFF;
+};
+
+inline EspClass ESP;
+
+#endif  // MOCK_ARDUINO_H_
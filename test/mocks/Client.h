@@ -0,0 +1,21 @@
+// Arduino Client interface for the native tests
+
+#ifndef MOCK_CLIENT_H_
+#define MOCK_CLIENT_H_
+
+#include <Arduino.h>
+
+class Client : public Stream {
+ public:
+  virtual int connect(const char* host, uint16_t port) = 0;
+  using Print::write;
+  virtual size_t write(uint8_t c) override = 0;
+  virtual size_t write(const uint8_t* buf, size_t size) override = 0;
+  virtual int available() override = 0;
+  virtual int read() override = 0;
+  virtual int read(uint8_t* buf, size_t size) = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+};
+
+#endif  // MOCK_CLIENT_H_
@@ -0,0 +1,15 @@
+// Arduino WiFi stand-in for the native tests
+
+#ifndef MOCK_WIFI_H_
+#define MOCK_WIFI_H_
+
+#include <Arduino.h>
+
+class WiFiClass {
+ public:
+  bool isConnected() const { return true; }
+};
+
+inline WiFiClass WiFi;
+
+#endif  // MOCK_WIFI_H_
@@ -0,0 +1,123 @@
+// Arduino UDP stand-in for the native tests
+//
+// Sockets exchange datagrams over an in-memory network. Each socket takes
+// its host name from UdpNetwork::next_host when it is created, so a test
+// can run several controllers in one process. Hosts marked down neither
+// send nor receive, which partitions them from the rest.
+
+#ifndef MOCK_WIFIUDP_H_
+#define MOCK_WIFIUDP_H_
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mock {
+
+struct UdpNetwork {
+  using Datagram = std::vector<uint8_t>;
+
+  std::string next_host = "127.0.0.1";
+  std::set<std::string> down;
+  // Inboxes by "host:port" of the bound sockets.
+  std::map<std::string, std::deque<Datagram>> inboxes;
+  uint32_t delivered = 0;
+  uint32_t dropped = 0;
+
+  static std::string address(const std::string& host, uint16_t port) {
+    return host + ":" + std::to_string(port);
+  }
+
+  void send(const std::string& from, const std::string& to_host,
+            uint16_t port, const Datagram& datagram) {
+    auto inbox = inboxes.find(address(to_host, port));
+    if (down.count(from) > 0 || down.count(to_host) > 0 ||
+        inbox == inboxes.end()) {
+      dropped++;
+      return;
+    }
+    inbox->second.push_back(datagram);
+    delivered++;
+  }
+
+  void clear() {
+    next_host = "127.0.0.1";
+    down.clear();
+    inboxes.clear();
+    delivered = 0;
+    dropped = 0;
+  }
+};
+
+inline UdpNetwork& udp_network() {
+  static UdpNetwork network;
+  return network;
+}
+
+}  // namespace mock
+
+class WiFiUDP {
+ public:
+  WiFiUDP() : host_(mock::udp_network().next_host) {}
+  ~WiFiUDP() { stop(); }
+
+  uint8_t begin(uint16_t port) {
+    address_ = mock::UdpNetwork::address(host_, port);
+    mock::udp_network().inboxes[address_];
+    return 1;
+  }
+  void stop() {
+    if (!address_.empty()) {
+      mock::udp_network().inboxes.erase(address_);
+      address_.clear();
+    }
+  }
+
+  int parsePacket() {
+    auto inbox = mock::udp_network().inboxes.find(address_);
+    if (inbox == mock::udp_network().inboxes.end() || inbox->second.empty()) {
+      return 0;
+    }
+    packet_ = inbox->second.front();
+    inbox->second.pop_front();
+    read_pos_ = 0;
+    return packet_.size();
+  }
+  int read(uint8_t* buf, size_t len) {
+    size_t n = std::min(len, packet_.size() - read_pos_);
+    memcpy(buf, packet_.data() + read_pos_, n);
+    read_pos_ += n;
+    return n;
+  }
+
+  int beginPacket(const char* host, uint16_t port) {
+    out_host_ = host;
+    out_port_ = port;
+    out_.clear();
+    return 1;
+  }
+  size_t write(const uint8_t* buf, size_t size) {
+    out_.insert(out_.end(), buf, buf + size);
+    return size;
+  }
+  int endPacket() {
+    mock::udp_network().send(host_, out_host_, out_port_, out_);
+    return 1;
+  }
+
+ private:
+  std::string host_;
+  std::string address_;
+  std::vector<uint8_t> packet_;
+  size_t read_pos_ = 0;
+  std::string out_host_;
+  uint16_t out_port_ = 0;
+  std::vector<uint8_t> out_;
+};
+
+#endif  // MOCK_WIFIUDP_H_
@@ -0,0 +1,72 @@
+// Heap allocation counting for the native tests
+//
+// Replaces the global operator new and delete. Include this header in
+// exactly one translation unit of a test program.
+
+#ifndef MOCK_ALLOC_COUNTER_H_
+#define MOCK_ALLOC_COUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace mock {
+
+struct AllocCounts {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+};
+
+inline AllocCounts& alloc_counts() {
+  static AllocCounts counts;
+  return counts;
+}
+
+// Counts the allocations made while it is in scope.
+class AllocScope {
+ public:
+  AllocScope()
+      : allocations_(alloc_counts().allocations),
+        bytes_(alloc_counts().bytes) {}
+
+  uint64_t allocations() const {
+    return alloc_counts().allocations - allocations_;
+  }
+  uint64_t bytes() const { return alloc_counts().bytes - bytes_; }
+
+ private:
+  uint64_t allocations_;
+  uint64_t bytes_;
+};
+
+}  // namespace mock
+
+// Out of line, so that the compiler does not pair the malloc() and free()
+// inside with the allocation calls it inlines them into.
+__attribute__((noinline)) void* operator new(size_t size) {
+  mock::alloc_counts().allocations++;
+  mock::alloc_counts().bytes += size;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+__attribute__((noinline)) void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept {
+  free(p);
+}
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+#endif  // MOCK_ALLOC_COUNTER_H_
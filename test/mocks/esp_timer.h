@@ -0,0 +1,14 @@
+// ESP-IDF high resolution timer stand-in for the native tests
+
+#ifndef MOCK_ESP_TIMER_H_
+#define MOCK_ESP_TIMER_H_
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+inline int64_t esp_timer_get_time() {
+  return static_cast<int64_t>(mock::now_ms()) * 1000;
+}
+
+#endif  // MOCK_ESP_TIMER_H_
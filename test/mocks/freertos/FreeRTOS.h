@@ -0,0 +1,17 @@
+// FreeRTOS stand-in for the native tests
+
+#ifndef MOCK_FREERTOS_FREERTOS_H_
+#define MOCK_FREERTOS_FREERTOS_H_
+
+#include <cstdint>
+
+using BaseType_t = int;
+using UBaseType_t = unsigned int;
+using TickType_t = uint32_t;
+
+constexpr BaseType_t pdTRUE = 1;
+constexpr BaseType_t pdFALSE = 0;
+constexpr BaseType_t pdPASS = 1;
+constexpr TickType_t portMAX_DELAY = UINT32_MAX;
+
+#endif  // MOCK_FREERTOS_FREERTOS_H_
@@ -0,0 +1,64 @@
+// FreeRTOS task stand-in for the native tests
+//
+// Tasks run on host threads and only the task notification calls are
+// provided. Task threads are detached and never deleted, like the tasks the
+// firmware creates during setup.
+
+#ifndef MOCK_FREERTOS_TASK_H_
+#define MOCK_FREERTOS_TASK_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "freertos/FreeRTOS.h"
+
+struct MockTask {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t notifications = 0;
+};
+
+using TaskHandle_t = MockTask*;
+using TaskFunction_t = void (*)(void*);
+
+namespace mock {
+
+inline thread_local MockTask* current_task = nullptr;
+
+}  // namespace mock
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name,
+                              uint32_t stack_depth, void* arg,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+  auto* task = new MockTask();
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  std::thread([function, arg, task]() {
+    mock::current_task = task;
+    function(arg);
+  }).detach();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->notifications++;
+  task->notified.notify_one();
+  return pdPASS;
+}
+
+// Only portMAX_DELAY is supported as the timeout.
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit,
+                                 TickType_t ticks_to_wait) {
+  MockTask* task = mock::current_task;
+  std::unique_lock<std::mutex> lock(task->mutex);
+  task->notified.wait(lock, [task]() { return task->notifications > 0; });
+  uint32_t count = task->notifications;
+  task->notifications = clear_on_exit ? 0 : count - 1;
+  return count;
+}
+
+#endif  // MOCK_FREERTOS_TASK_H_
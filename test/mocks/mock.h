@@ -0,0 +1,58 @@
+// Test helpers for driving the mocked platform
+//
+// reset() returns every mock to its initial state; call it from setUp() so
+// that callbacks of modules from an earlier test never run again.
+// advance() moves the simulated clock and runs the event loop on the way.
+
+#ifndef MOCK_MOCK_H_
+#define MOCK_MOCK_H_
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#include <cstdint>
+
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_listener.h"
+#include "sensesp/signalk/signalk_put_request.h"
+#include "sensesp_app.h"
+
+namespace mock {
+
+// Room for the PUTs of a long simulation without reallocating.
+constexpr size_t kPutLogCapacity = 1 << 16;
+
+inline void reset(uint64_t start_ms = 100000) {
+  loop().clear();
+  now_ms() = start_ms;
+  puts().clear();
+  puts().reserve(kPutLogCapacity);
+  requests().clear();
+  udp_network().clear();
+  sensesp::SKListener::listeners().clear();
+  sensesp::sensesp_app = std::make_shared<sensesp::SensESPApp>();
+  ESP.efuse_mac = 0x0000AABBCCDDEEFF;
+}
+
+inline std::shared_ptr<sensesp::SKWSClient> ws_client() {
+  return sensesp::sensesp_app->get_ws_client();
+}
+
+// Run n loop passes without moving the clock.
+inline void tick(int n = 1) {
+  for (int i = 0; i < n; i++) {
+    loop().tick();
+  }
+}
+
+// Move the clock by ms, running the loop every step_ms.
+inline void advance(uint32_t ms, uint32_t step_ms = 1) {
+  for (uint32_t t = 0; t < ms; t += step_ms) {
+    now_ms() += step_ms;
+    loop().tick();
+  }
+}
+
+}  // namespace mock
+
+#endif  // MOCK_MOCK_H_
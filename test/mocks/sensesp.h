@@ -0,0 +1,107 @@
+// SensESP core stand-in for the native tests
+//
+// MockEventLoop runs the callbacks the modules register, against the
+// simulated clock of the Arduino mock: repeating and delayed callbacks when
+// they fall due, then every tick callback, as ReactESP does. Log messages
+// are dropped unless the MOCK_LOG environment variable is set.
+
+#ifndef MOCK_SENSESP_H_
+#define MOCK_SENSESP_H_
+
+#include <Arduino.h>
+
+#include <cstdarg>
+#include <cstdint>
+#include <functional>
+#include <list>
+
+namespace mock {
+
+class MockEventLoop {
+ public:
+  struct Event {
+    std::function<void()> callback;
+    // Zero for tick callbacks.
+    uint32_t interval_ms;
+    uint64_t due_ms;
+    bool repeat;
+  };
+
+  Event* onTick(std::function<void()> callback) {
+    ticks_.push_back({callback, 0, 0, true});
+    return &ticks_.back();
+  }
+  Event* onRepeat(uint32_t interval_ms, std::function<void()> callback) {
+    timed_.push_back({callback, interval_ms, now_ms() + interval_ms, true});
+    return &timed_.back();
+  }
+  Event* onDelay(uint32_t delay_ms, std::function<void()> callback) {
+    timed_.push_back({callback, delay_ms, now_ms() + delay_ms, false});
+    return &timed_.back();
+  }
+
+  // Run one pass of the loop at the current simulated time.
+  void tick() {
+    for (auto it = timed_.begin(); it != timed_.end();) {
+      if (it->due_ms > now_ms()) {
+        ++it;
+        continue;
+      }
+      it->callback();
+      if (it->repeat) {
+        it->due_ms += it->interval_ms;
+        ++it;
+      } else {
+        it = timed_.erase(it);
+      }
+    }
+    for (Event& event : ticks_) {
+      event.callback();
+    }
+  }
+
+  void clear() {
+    ticks_.clear();
+    timed_.clear();
+  }
+
+ private:
+  // Lists, so that callbacks registered from a callback do not invalidate
+  // the iteration.
+  std::list<Event> ticks_;
+  std::list<Event> timed_;
+};
+
+inline MockEventLoop& loop() {
+  static MockEventLoop instance;
+  return instance;
+}
+
+__attribute__((format(printf, 2, 3))) inline void log(char level,
+                                                       const char* format,
+                                                       ...) {
+  if (getenv("MOCK_LOG") == nullptr) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  printf("[%c] ", level);
+  vprintf(format, args);
+  printf("\n");
+  va_end(args);
+}
+
+}  // namespace mock
+
+namespace sensesp {
+
+inline mock::MockEventLoop* event_loop() { return &mock::loop(); }
+
+}  // namespace sensesp
+
+#define debugD(...) mock::log('D', __VA_ARGS__)
+#define debugI(...) mock::log('I', __VA_ARGS__)
+#define debugW(...) mock::log('W', __VA_ARGS__)
+#define debugE(...) mock::log('E', __VA_ARGS__)
+
+#endif  // MOCK_SENSESP_H_
@@ -0,0 +1,51 @@
+// SensESP listener stand-in for the native tests
+//
+// Listeners register themselves so that tests can deliver values to them.
+
+#ifndef MOCK_SENSESP_SIGNALK_SIGNALK_LISTENER_H_
+#define MOCK_SENSESP_SIGNALK_SIGNALK_LISTENER_H_
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <vector>
+
+namespace sensesp {
+
+class SKListener {
+ public:
+  SKListener(String sk_path, int listen_delay, String config_path = "")
+      : sk_path_(sk_path) {
+    listeners().push_back(this);
+  }
+  virtual ~SKListener() {}
+
+  virtual void parse_value(const JsonObject& json) {}
+
+  const String& get_sk_path() const { return sk_path_; }
+
+  static std::vector<SKListener*>& listeners() {
+    static std::vector<SKListener*> registry;
+    return registry;
+  }
+
+ private:
+  String sk_path_;
+};
+
+}  // namespace sensesp
+
+namespace mock {
+
+// Hand a delta value to every listener of the path.
+inline void deliver(const char* path, JsonObject value) {
+  for (auto* listener : sensesp::SKListener::listeners()) {
+    if (listener->get_sk_path() == path) {
+      listener->parse_value(value);
+    }
+  }
+}
+
+}  // namespace mock
+
+#endif  // MOCK_SENSESP_SIGNALK_SIGNALK_LISTENER_H_
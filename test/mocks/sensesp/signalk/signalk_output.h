@@ -0,0 +1,35 @@
+// SensESP output stand-ins for the native tests
+
+#ifndef MOCK_SENSESP_SIGNALK_SIGNALK_OUTPUT_H_
+#define MOCK_SENSESP_SIGNALK_SIGNALK_OUTPUT_H_
+
+#include <Arduino.h>
+
+#include "sensesp/system/valueproducer.h"
+
+namespace sensesp {
+
+class SKMetadata {
+ public:
+  SKMetadata(String units) : units_(units) {}
+
+ private:
+  String units_;
+};
+
+class SKOutputFloat : public ValueConsumer<float> {
+ public:
+  SKOutputFloat(String sk_path, String config_path = "",
+                SKMetadata* metadata = nullptr)
+      : sk_path_(sk_path) {}
+
+  void set(const float& value) override { value_ = value; }
+
+ private:
+  String sk_path_;
+  float value_ = 0;
+};
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_SIGNALK_SIGNALK_OUTPUT_H_
@@ -0,0 +1,92 @@
+// SensESP PUT request stand-ins for the native tests
+//
+// Requests and PUTs are recorded instead of sent. The PUT log is reserved up
+// front so that recording a PUT does not allocate and the allocation counts
+// of the tests only see the code under test.
+
+#ifndef MOCK_SENSESP_SIGNALK_SIGNALK_PUT_REQUEST_H_
+#define MOCK_SENSESP_SIGNALK_SIGNALK_PUT_REQUEST_H_
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "sensesp/system/valueproducer.h"
+
+namespace mock {
+
+struct Put {
+  // The SKPutRequest that sent it.
+  const void* sender;
+  const char* path;
+  double value;
+  uint64_t at_ms;
+};
+
+struct Request {
+  std::shared_ptr<JsonDocument> request;
+  std::function<void(JsonDocument&)> callback;
+};
+
+inline std::vector<Put>& puts() {
+  static std::vector<Put> log;
+  return log;
+}
+
+inline std::vector<Request>& requests() {
+  static std::vector<Request> log;
+  return log;
+}
+
+// Answer a recorded request as the server would.
+inline void respond(size_t index, int status_code,
+                    const char* message = nullptr) {
+  JsonDocument response;
+  response["state"] = "COMPLETED";
+  response["statusCode"] = status_code;
+  if (message != nullptr) {
+    response["message"] = message;
+  }
+  requests()[index].callback(response);
+}
+
+}  // namespace mock
+
+namespace sensesp {
+
+class SKRequest {
+ public:
+  static void send_request(JsonDocument& request,
+                           std::function<void(JsonDocument&)> callback,
+                           uint32_t timeout = 5000) {
+    mock::requests().push_back(
+        {std::make_shared<JsonDocument>(request), callback});
+  }
+};
+
+template <typename T>
+class SKPutRequest : public ValueConsumer<T> {
+ public:
+  SKPutRequest(String sk_path, String config_path = "",
+               uint32_t timeout = 5000)
+      : sk_path_(sk_path) {}
+
+  void set(const T& value) override {
+    mock::puts().push_back(
+        {this, sk_path_.c_str(), static_cast<double>(value), mock::now_ms()});
+  }
+
+  String get_sk_path() const { return sk_path_; }
+  void set_sk_path(const String& path) { sk_path_ = path; }
+
+ private:
+  String sk_path_;
+};
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_SIGNALK_SIGNALK_PUT_REQUEST_H_
@@ -0,0 +1,47 @@
+// SensESP websocket client stand-in for the native tests
+//
+// Records what the application sends and lets tests drive the connection
+// state.
+
+#ifndef MOCK_SENSESP_SIGNALK_SIGNALK_WS_CLIENT_H_
+#define MOCK_SENSESP_SIGNALK_SIGNALK_WS_CLIENT_H_
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "sensesp/system/valueproducer.h"
+
+namespace sensesp {
+
+enum class SKWSConnectionState {
+  kSKWSDisconnected,
+  kSKWSAuthorizing,
+  kSKWSConnecting,
+  kSKWSConnected
+};
+
+class SKWSClient : public ValueProducer<SKWSConnectionState> {
+ public:
+  bool is_connected() const { return connected_; }
+
+  void sendTXT(String& payload) { sent_.push_back(payload); }
+  void restart() { restarts_++; }
+
+  // Test controls.
+  void set_state(SKWSConnectionState state) {
+    connected_ = state == SKWSConnectionState::kSKWSConnected;
+    emit(state);
+  }
+  const std::vector<String>& sent() const { return sent_; }
+  int restarts() const { return restarts_; }
+
+ private:
+  bool connected_ = true;
+  std::vector<String> sent_;
+  int restarts_ = 0;
+};
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_SIGNALK_SIGNALK_WS_CLIENT_H_
@@ -0,0 +1,25 @@
+// SensESP LambdaConsumer stand-in for the native tests
+
+#ifndef MOCK_SENSESP_SYSTEM_LAMBDA_CONSUMER_H_
+#define MOCK_SENSESP_SYSTEM_LAMBDA_CONSUMER_H_
+
+#include <functional>
+
+#include "sensesp/system/valueproducer.h"
+
+namespace sensesp {
+
+template <typename T>
+class LambdaConsumer : public ValueConsumer<T> {
+ public:
+  LambdaConsumer(std::function<void(T)> function) : function_(function) {}
+
+  void set(const T& value) override { function_(value); }
+
+ private:
+  std::function<void(T)> function_;
+};
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_SYSTEM_LAMBDA_CONSUMER_H_
@@ -0,0 +1,21 @@
+// SensESP ObservableValue stand-in for the native tests
+
+#ifndef MOCK_SENSESP_SYSTEM_OBSERVABLEVALUE_H_
+#define MOCK_SENSESP_SYSTEM_OBSERVABLEVALUE_H_
+
+#include "sensesp/system/valueproducer.h"
+
+namespace sensesp {
+
+template <typename T>
+class ObservableValue : public ValueConsumer<T>, public ValueProducer<T> {
+ public:
+  ObservableValue() {}
+  ObservableValue(const T& value) { this->output_ = value; }
+
+  void set(const T& value) override { this->emit(value); }
+};
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_SYSTEM_OBSERVABLEVALUE_H_
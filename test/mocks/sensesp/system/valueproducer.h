@@ -0,0 +1,52 @@
+// SensESP producer and consumer stand-ins for the native tests
+
+#ifndef MOCK_SENSESP_SYSTEM_VALUEPRODUCER_H_
+#define MOCK_SENSESP_SYSTEM_VALUEPRODUCER_H_
+
+#include <functional>
+#include <vector>
+
+namespace sensesp {
+
+template <typename T>
+class ValueConsumer {
+ public:
+  virtual ~ValueConsumer() {}
+  virtual void set(const T& value) = 0;
+};
+
+template <typename T>
+class ValueProducer {
+ public:
+  virtual ~ValueProducer() {}
+
+  const T& get() const { return output_; }
+
+  void connect_to(ValueConsumer<T>* consumer) {
+    consumers_.push_back(consumer);
+  }
+  void attach(std::function<void()> observer) {
+    observers_.push_back(observer);
+  }
+
+  void emit(const T& value) {
+    output_ = value;
+    for (auto* consumer : consumers_) {
+      consumer->set(value);
+    }
+    for (auto& observer : observers_) {
+      observer();
+    }
+  }
+
+ protected:
+  T output_ = T();
+
+ private:
+  std::vector<ValueConsumer<T>*> consumers_;
+  std::vector<std::function<void()>> observers_;
+};
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_SYSTEM_VALUEPRODUCER_H_
@@ -0,0 +1,38 @@
+// SensESP application stand-in for the native tests
+
+#ifndef MOCK_SENSESP_APP_H_
+#define MOCK_SENSESP_APP_H_
+
+#include <Arduino.h>
+
+#include <memory>
+
+#include "sensesp/signalk/signalk_ws_client.h"
+
+namespace sensesp {
+
+class SensESPBaseApp {
+ public:
+  static String get_hostname() { return hostname(); }
+
+  // Test control.
+  static String& hostname() {
+    static String name = "test-node";
+    return name;
+  }
+};
+
+class SensESPApp : public SensESPBaseApp {
+ public:
+  std::shared_ptr<SKWSClient> get_ws_client() { return ws_client_; }
+
+ private:
+  std::shared_ptr<SKWSClient> ws_client_ = std::make_shared<SKWSClient>();
+};
+
+inline std::shared_ptr<SensESPApp> sensesp_app =
+    std::make_shared<SensESPApp>();
+
+}  // namespace sensesp
+
+#endif  // MOCK_SENSESP_APP_H_
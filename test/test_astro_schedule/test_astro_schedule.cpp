@@ -0,0 +1,180 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "astro_schedule.h"
+#include "clock_sync.h"
+#include "mock.h"
+
+namespace {
+
+// 2024-06-21T00:00:00Z and 2024-12-21T00:00:00Z.
+constexpr int64_t kMidsummerMs = 1718928000000;
+constexpr int64_t kMidwinterMs = 1734739200000;
+constexpr int64_t kHourMs = 3600000;
+constexpr int64_t kMinuteMs = 60000;
+
+constexpr float kLondonLat = 51.5074;
+constexpr float kLondonLon = -0.1278;
+
+struct Command {
+  bool state;
+  int64_t server_ms;
+};
+
+std::vector<Command> commands;
+
+void record(bool state) {
+  commands.push_back({state, clock_sync->server_time_ms()});
+}
+
+void deliver_position(float latitude, float longitude) {
+  JsonDocument delta;
+  JsonObject value = delta["value"].to<JsonObject>();
+  value["latitude"] = latitude;
+  value["longitude"] = longitude;
+  mock::deliver("navigation.position", delta.as<JsonObject>());
+}
+
+int64_t london(SolarEvent event, int64_t day = kMidsummerMs) {
+  return AstroSchedule::event_time_ms(day, kLondonLat, kLondonLon, event);
+}
+
+}  // namespace
+
+void setUp() {
+  mock::reset();
+  commands.clear();
+  clock_sync = new ClockSync();
+}
+
+void tearDown() {
+  delete clock_sync;
+  clock_sync = nullptr;
+}
+
+// Times from the NOAA solar calculator for London on 2024-06-21, in UTC.
+void test_london_midsummer() {
+  TEST_ASSERT_INT64_WITHIN(3 * kMinuteMs,
+                           kMidsummerMs + 3 * kHourMs + 43 * kMinuteMs,
+                           london(SolarEvent::kSunrise));
+  TEST_ASSERT_INT64_WITHIN(3 * kMinuteMs,
+                           kMidsummerMs + 20 * kHourMs + 21 * kMinuteMs,
+                           london(SolarEvent::kSunset));
+  TEST_ASSERT_INT64_WITHIN(3 * kMinuteMs,
+                           kMidsummerMs + 2 * kHourMs + 55 * kMinuteMs,
+                           london(SolarEvent::kCivilDawn));
+  TEST_ASSERT_INT64_WITHIN(3 * kMinuteMs,
+                           kMidsummerMs + 21 * kHourMs + 9 * kMinuteMs,
+                           london(SolarEvent::kCivilDusk));
+}
+
+// And on 2024-12-21: sunrise 08:04, sunset 15:54.
+void test_london_midwinter() {
+  TEST_ASSERT_INT64_WITHIN(3 * kMinuteMs,
+                           kMidwinterMs + 8 * kHourMs + 4 * kMinuteMs,
+                           london(SolarEvent::kSunrise, kMidwinterMs));
+  TEST_ASSERT_INT64_WITHIN(3 * kMinuteMs,
+                           kMidwinterMs + 15 * kHourMs + 54 * kMinuteMs,
+                           london(SolarEvent::kSunset, kMidwinterMs));
+}
+
+void test_polar_day_and_night_have_no_events() {
+  const float lat = 69.6492;
+  const float lon = 18.9553;
+  TEST_ASSERT_EQUAL_INT64(
+      -1, AstroSchedule::event_time_ms(kMidsummerMs, lat, lon,
+                                       SolarEvent::kSunset));
+  TEST_ASSERT_EQUAL_INT64(
+      -1, AstroSchedule::event_time_ms(kMidwinterMs, lat, lon,
+                                       SolarEvent::kSunrise));
+}
+
+void test_nothing_switches_before_the_clock_is_synced() {
+  AstroSchedule schedule;
+  schedule.add_rule({0, SolarEvent::kSunset, SolarEvent::kSunrise}, record);
+  deliver_position(kLondonLat, kLondonLon);
+  mock::advance(10000, 100);
+  TEST_ASSERT_EQUAL(0, commands.size());
+}
+
+void test_clock_replies_without_a_time_are_discarded() {
+  mock::advance(30000, 1000);
+  TEST_ASSERT_EQUAL(1, mock::requests().size());
+  mock::respond(0, 200);
+  TEST_ASSERT_FALSE(clock_sync->is_synced());
+
+  mock::advance(30000, 1000);
+  TEST_ASSERT_EQUAL(2, mock::requests().size());
+  mock::respond(1, 200, "1718928000000");
+  TEST_ASSERT_TRUE(clock_sync->is_synced());
+}
+
+void test_catches_up_then_follows_the_table() {
+  AstroSchedule schedule;
+  schedule.add_rule({0, SolarEvent::kSunset, SolarEvent::kSunrise}, record);
+  deliver_position(kLondonLat, kLondonLon);
+  int64_t now = ClockSync::local_ms();
+  clock_sync->add_sample(now, kMidsummerMs + 12 * kHourMs, now);
+
+  // At noon, the latest event was sunrise: lights off.
+  mock::advance(1000, 100);
+  TEST_ASSERT_EQUAL(1, commands.size());
+  TEST_ASSERT_FALSE(commands[0].state);
+
+  // On at sunset, within the check interval.
+  mock::advance(10 * kHourMs, 1000);
+  TEST_ASSERT_EQUAL(2, commands.size());
+  TEST_ASSERT_TRUE(commands[1].state);
+  int64_t sunset = london(SolarEvent::kSunset);
+  TEST_ASSERT_INT64_WITHIN(1000, sunset + 500, commands[1].server_ms);
+
+  // Off at the next sunrise, from the table built at midnight.
+  mock::advance(10 * kHourMs, 1000);
+  TEST_ASSERT_EQUAL(3, commands.size());
+  TEST_ASSERT_FALSE(commands[2].state);
+  int64_t sunrise = AstroSchedule::event_time_ms(
+      kMidsummerMs + 24 * kHourMs, kLondonLat, kLondonLon,
+      SolarEvent::kSunrise);
+  TEST_ASSERT_INT64_WITHIN(1000, sunrise + 500, commands[2].server_ms);
+}
+
+void test_offset_shifts_events() {
+  AstroSchedule schedule;
+  schedule.add_rule({0, SolarEvent::kSunset, SolarEvent::kSunrise, -15},
+                    record);
+  deliver_position(kLondonLat, kLondonLon);
+  int64_t now = ClockSync::local_ms();
+  clock_sync->add_sample(now, kMidsummerMs + 20 * kHourMs, now);
+  mock::advance(kHourMs, 1000);
+  TEST_ASSERT_EQUAL(2, commands.size());
+  int64_t sunset = london(SolarEvent::kSunset);
+  TEST_ASSERT_INT64_WITHIN(1000, sunset - 15 * kMinuteMs + 500,
+                           commands[1].server_ms);
+}
+
+void test_catch_up_after_sunset() {
+  AstroSchedule schedule;
+  schedule.add_rule({0, SolarEvent::kCivilDusk, SolarEvent::kCivilDawn},
+                    record);
+  deliver_position(kLondonLat, kLondonLon);
+  int64_t now = ClockSync::local_ms();
+  // Shortly after midnight; dusk was yesterday.
+  clock_sync->add_sample(now, kMidsummerMs + 10 * kMinuteMs, now);
+  mock::advance(1000, 100);
+  TEST_ASSERT_EQUAL(1, commands.size());
+  TEST_ASSERT_TRUE(commands[0].state);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_london_midsummer);
+  RUN_TEST(test_london_midwinter);
+  RUN_TEST(test_polar_day_and_night_have_no_events);
+  RUN_TEST(test_nothing_switches_before_the_clock_is_synced);
+  RUN_TEST(test_clock_replies_without_a_time_are_discarded);
+  RUN_TEST(test_catches_up_then_follows_the_table);
+  RUN_TEST(test_offset_shifts_events);
+  RUN_TEST(test_catch_up_after_sunset);
+  return UNITY_END();
+}
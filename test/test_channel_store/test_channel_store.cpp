@@ -0,0 +1,217 @@
+#include <unity.h>
+
+#include "alloc_counter.h"
+#include "baselines.h"
+#include "channel_store.h"
+#include "mock.h"
+
+void setUp() { mock::reset(); }
+void tearDown() {}
+
+void test_command_is_pending_until_confirmed() {
+  ChannelStore store;
+  store.add_channel(3);
+  store.command(3, true);
+  TEST_ASSERT_TRUE(store.pending()[3]);
+  TEST_ASSERT_TRUE(store.commanded(3));
+  TEST_ASSERT_FALSE(store.known(3));
+
+  mock::advance(120);
+  TEST_ASSERT_EQUAL_INT32(120, store.confirm(3, true));
+  TEST_ASSERT_FALSE(store.pending()[3]);
+  TEST_ASSERT_TRUE(store.known(3));
+  TEST_ASSERT_TRUE(store.state(3));
+}
+
+void test_other_state_does_not_confirm() {
+  ChannelStore store;
+  store.add_channel(0);
+  store.command(0, true);
+  TEST_ASSERT_EQUAL_INT32(-1, store.confirm(0, false));
+  TEST_ASSERT_TRUE(store.pending()[0]);
+  TEST_ASSERT_TRUE(store.known(0));
+  TEST_ASSERT_FALSE(store.state(0));
+  TEST_ASSERT_EQUAL_UINT32(0, store.latency_count(0));
+}
+
+void test_unregistered_channels_are_ignored() {
+  ChannelStore store;
+  store.command(5, true);
+  TEST_ASSERT_TRUE(store.pending().none());
+  TEST_ASSERT_EQUAL_INT32(-1, store.confirm(5, true));
+  TEST_ASSERT_FALSE(store.known(5));
+  TEST_ASSERT_EQUAL_UINT32(0, store.version());
+}
+
+void test_version_changes_only_with_the_state() {
+  ChannelStore store;
+  store.add_channel(1);
+  store.add_channel(2);
+  store.confirm(1, true);
+  uint32_t version = store.version();
+  store.confirm(1, true);
+  TEST_ASSERT_EQUAL_UINT32(version, store.version());
+
+  mock::advance(10);
+  store.confirm(2, false);
+  TEST_ASSERT_EQUAL_UINT32(version + 1, store.version());
+  TEST_ASSERT_EQUAL_UINT32(mock::now_ms(), store.changed_at(2));
+
+  ChannelSet changed = store.changed_since(version);
+  TEST_ASSERT_EQUAL(1, changed.count());
+  TEST_ASSERT_TRUE(changed[2]);
+  TEST_ASSERT_TRUE(store.changed_since(store.version()).none());
+  TEST_ASSERT_EQUAL(2, store.changed_since(0).count());
+}
+
+void test_scan_pending_by_age() {
+  ChannelStore store;
+  store.add_channel(0);
+  store.add_channel(1);
+  store.command(0, true);
+  mock::advance(300);
+  store.command(1, true);
+  mock::advance(200);
+
+  uint32_t now = millis();
+  ChannelSet old = store.scan_pending(500, now);
+  TEST_ASSERT_EQUAL(1, old.count());
+  TEST_ASSERT_TRUE(old[0]);
+  TEST_ASSERT_EQUAL(2, store.scan_pending(200, now).count());
+  TEST_ASSERT_TRUE(store.scan_pending(501, now).none());
+}
+
+void test_scan_pending_across_millis_wrap() {
+  mock::reset(UINT32_MAX - 100);
+  ChannelStore store;
+  store.add_channel(0);
+  store.command(0, true);
+  mock::advance(300);
+  TEST_ASSERT_TRUE(store.scan_pending(300, millis())[0]);
+}
+
+void test_settled_channels() {
+  ChannelStore store;
+  store.add_channel(0);
+  store.add_channel(1);
+  store.confirm(0, true);
+  store.confirm(1, false);
+  // A standby learns about commands from its peer, and about states from
+  // the server.
+  ChannelSet commanded;
+  commanded.set(0).set(1);
+  store.replicate(commanded, commanded);
+  ChannelSet settled = store.settled();
+  TEST_ASSERT_EQUAL(1, settled.count());
+  TEST_ASSERT_TRUE(settled[0]);
+}
+
+void test_replicate_masks_unregistered_channels() {
+  ChannelStore store;
+  store.add_channel(4);
+  ChannelSet bits;
+  bits.set(4).set(5);
+  store.replicate(bits, bits);
+  TEST_ASSERT_EQUAL(1, store.commanded_states().count());
+  TEST_ASSERT_EQUAL(1, store.pending().count());
+  TEST_ASSERT_TRUE(store.pending()[4]);
+}
+
+void test_replicated_commands_are_timed_from_arrival() {
+  ChannelStore store;
+  store.add_channel(0);
+  store.add_channel(1);
+  store.command(1, true);
+  mock::advance(10000);
+
+  // Channel 0 is new; channel 1 is pending with another command.
+  ChannelSet commanded;
+  commanded.set(0);
+  ChannelSet pending;
+  pending.set(0).set(1);
+  store.replicate(commanded, pending);
+  TEST_ASSERT_EQUAL_UINT32(millis(), store.commanded_at(0));
+  TEST_ASSERT_EQUAL_UINT32(millis(), store.commanded_at(1));
+  TEST_ASSERT_TRUE(store.scan_pending(1, millis()).none());
+
+  // Repeated frames keep the time of arrival.
+  mock::advance(200);
+  store.replicate(commanded, pending);
+  TEST_ASSERT_EQUAL_UINT32(millis() - 200, store.commanded_at(0));
+  TEST_ASSERT_EQUAL_INT32(200, store.confirm(0, true));
+}
+
+void test_snapshot_copies_the_store() {
+  ChannelStore store;
+  store.add_channel(0);
+  store.add_channel(7);
+  store.command(7, true);
+  store.confirm(0, true);
+
+  ChannelStore::Snapshot snapshot;
+  store.snapshot(&snapshot);
+  TEST_ASSERT_EQUAL_UINT32(store.version(), snapshot.version);
+  TEST_ASSERT_TRUE(snapshot.registered == store.registered());
+  TEST_ASSERT_TRUE(snapshot.pending[7]);
+  TEST_ASSERT_TRUE(snapshot.state[0]);
+  TEST_ASSERT_EQUAL_UINT32(store.version(), snapshot.versions[0]);
+}
+
+void test_latency_accumulators() {
+  ChannelStore store;
+  store.add_channel(2);
+  for (uint32_t latency : {40, 100, 60}) {
+    store.command(2, !store.commanded(2));
+    mock::advance(latency);
+    store.confirm(2, store.commanded(2));
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, store.latency_count(2));
+  TEST_ASSERT_EQUAL_UINT32(200, store.latency_sum_ms(2));
+  TEST_ASSERT_EQUAL_UINT32(100, store.latency_max_ms(2));
+
+  store.reset_latency();
+  TEST_ASSERT_EQUAL_UINT32(0, store.latency_count(2));
+  TEST_ASSERT_EQUAL_UINT32(0, store.latency_sum_ms(2));
+  TEST_ASSERT_EQUAL_UINT32(0, store.latency_max_ms(2));
+}
+
+void test_store_size() {
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kChannelStoreBytes,
+                              sizeof(ChannelStore));
+}
+
+void test_events_do_not_allocate() {
+  ChannelStore store;
+  for (int i = 0; i < kMaxChannels; i++) {
+    store.add_channel(i);
+  }
+  constexpr int kEvents = 1000;
+  mock::AllocScope scope;
+  for (int n = 0; n < kEvents; n++) {
+    int channel = n % kMaxChannels;
+    store.command(channel, n & 1);
+    store.confirm(channel, n & 1);
+    store.scan_pending(500, millis());
+    store.changed_since(store.version() - 1);
+  }
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kAllocationsPerEvent,
+                              scope.allocations() / kEvents);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_command_is_pending_until_confirmed);
+  RUN_TEST(test_other_state_does_not_confirm);
+  RUN_TEST(test_unregistered_channels_are_ignored);
+  RUN_TEST(test_version_changes_only_with_the_state);
+  RUN_TEST(test_scan_pending_by_age);
+  RUN_TEST(test_scan_pending_across_millis_wrap);
+  RUN_TEST(test_settled_channels);
+  RUN_TEST(test_replicate_masks_unregistered_channels);
+  RUN_TEST(test_replicated_commands_are_timed_from_arrival);
+  RUN_TEST(test_snapshot_copies_the_store);
+  RUN_TEST(test_latency_accumulators);
+  RUN_TEST(test_store_size);
+  RUN_TEST(test_events_do_not_allocate);
+  return UNITY_END();
+}
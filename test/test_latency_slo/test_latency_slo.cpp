@@ -0,0 +1,165 @@
+#include <unity.h>
+
+#include <cstring>
+
+#include "channel_store.h"
+#include "compact_commands.h"
+#include "latency_slo.h"
+#include "mock.h"
+
+namespace {
+
+constexpr uint32_t kWindowMs = 60000;
+constexpr uint32_t kSliceMs = kWindowMs / LatencySlo::kNumSlices;
+
+// Confirm count commands with the given latency, then let a slice pass.
+void run_slice(LatencySlo* slo, int count, int32_t latency_ms) {
+  for (int n = 0; n < count; n++) {
+    slo->confirmed(n % 4, latency_ms);
+  }
+  mock::advance(kSliceMs, 10);
+}
+
+// Number of messages sent on the websocket that contain text.
+int sent_containing(const char* text) {
+  int count = 0;
+  for (const String& message : mock::ws_client()->sent()) {
+    if (strstr(message.c_str(), text) != nullptr) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+void setUp() { mock::reset(); }
+void tearDown() {}
+
+void test_latencies_report_their_bucket_bound() {
+  ChannelStore store;
+  LatencySlo slo(&store, nullptr, 0.99, 500, kWindowMs);
+  for (int n = 0; n < 60; n++) {
+    slo.confirmed(0, 25);
+  }
+  for (int n = 0; n < 40; n++) {
+    slo.confirmed(1, 26);
+  }
+  mock::advance(kSliceMs, 10);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.025, slo.median_latency_s().get());
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.05, slo.quantile_latency_s().get());
+}
+
+void test_bucket_bounds() {
+  const struct {
+    int32_t latency_ms;
+    float bound_s;
+  } cases[] = {{0, 0.025},  {100, 0.1},  {101, 0.2},  {499, 0.5},
+               {501, 0.75}, {2500, 3.0}, {10000, 10}};
+  for (const auto& c : cases) {
+    mock::reset();
+    ChannelStore store;
+    LatencySlo slo(&store, nullptr, 0.99, 500, kWindowMs);
+    slo.confirmed(0, c.latency_ms);
+    mock::advance(kSliceMs, 10);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, c.bound_s, slo.quantile_latency_s().get());
+  }
+}
+
+void test_late_and_invalid_confirmations_are_ignored() {
+  ChannelStore store;
+  LatencySlo slo(&store, nullptr, 0.99, 500, kWindowMs);
+  slo.confirmed(0, -1);
+  slo.confirmed(0, LatencySlo::kTimeoutMs + 1);
+  mock::advance(kSliceMs, 10);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0, slo.quantile_latency_s().get());
+}
+
+void test_unconfirmed_commands_count_as_timeouts() {
+  ChannelStore store;
+  store.add_channel(0);
+  LatencySlo slo(&store, nullptr, 0.99, 500, kWindowMs);
+  store.command(0, true);
+  mock::advance(kSliceMs, 10);
+  // Not yet past the timeout at the end of the first slice.
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0, slo.quantile_latency_s().get());
+  mock::advance(kSliceMs, 10);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 10, slo.quantile_latency_s().get());
+  // Counted once, not again in later slices.
+  for (int n = 0; n < 200; n++) {
+    slo.confirmed(1, 50);
+  }
+  mock::advance(kSliceMs, 10);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.05, slo.quantile_latency_s().get());
+}
+
+void test_misses_escalate_one_step_per_window() {
+  ChannelStore store;
+  CompactCommands compact;
+  compact.add_channel(0, new sensesp::SKPutRequest<bool>("a.state"));
+  mock::tick();
+  mock::respond(0, 200);
+  TEST_ASSERT_TRUE(compact.active());
+  LatencySlo slo(&store, &compact, 0.99, 500, kWindowMs, 10);
+
+  run_slice(&slo, 20, 800);
+  TEST_ASSERT_EQUAL(1, mock::ws_client()->restarts());
+  TEST_ASSERT_EQUAL_FLOAT(1, slo.escalation().get());
+
+  // The reconnect is judged after a full window.
+  for (int s = 1; s < LatencySlo::kNumSlices; s++) {
+    run_slice(&slo, 20, 800);
+  }
+  TEST_ASSERT_TRUE(compact.active());
+  run_slice(&slo, 20, 800);
+  TEST_ASSERT_FALSE(compact.active());
+  TEST_ASSERT_EQUAL_FLOAT(2, slo.escalation().get());
+  TEST_ASSERT_EQUAL(1, sent_containing("sloAction"));
+
+  for (int s = 0; s < LatencySlo::kNumSlices; s++) {
+    run_slice(&slo, 20, 800);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(3, slo.escalation().get());
+  TEST_ASSERT_EQUAL(1, sent_containing("\"alert\""));
+  TEST_ASSERT_EQUAL(1, mock::ws_client()->restarts());
+
+  // Back within the objective for a window: start over, clear the alert.
+  for (int s = 0; s < LatencySlo::kNumSlices; s++) {
+    run_slice(&slo, 20, 100);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0, slo.escalation().get());
+  TEST_ASSERT_EQUAL(1, sent_containing("\"normal\""));
+}
+
+void test_notify_follows_reconnect_without_compact_commands() {
+  ChannelStore store;
+  LatencySlo slo(&store, nullptr, 0.99, 500, kWindowMs, 10);
+  for (int s = 0; s <= LatencySlo::kNumSlices; s++) {
+    run_slice(&slo, 20, 800);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(3, slo.escalation().get());
+}
+
+void test_few_samples_take_no_action() {
+  ChannelStore store;
+  LatencySlo slo(&store, nullptr, 0.99, 500, kWindowMs, 10);
+  for (int s = 0; s < 3; s++) {
+    run_slice(&slo, 3, 2000);
+  }
+  TEST_ASSERT_EQUAL(0, mock::ws_client()->restarts());
+  // The fourth slice brings the window to the minimum.
+  run_slice(&slo, 3, 2000);
+  TEST_ASSERT_EQUAL(1, mock::ws_client()->restarts());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_latencies_report_their_bucket_bound);
+  RUN_TEST(test_bucket_bounds);
+  RUN_TEST(test_late_and_invalid_confirmations_are_ignored);
+  RUN_TEST(test_unconfirmed_commands_count_as_timeouts);
+  RUN_TEST(test_misses_escalate_one_step_per_window);
+  RUN_TEST(test_notify_follows_reconnect_without_compact_commands);
+  RUN_TEST(test_few_samples_take_no_action);
+  return UNITY_END();
+}
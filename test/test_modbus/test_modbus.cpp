@@ -0,0 +1,466 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mock.h"
+#include "modbus_relay_board.h"
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+class MockSerial : public Stream {
+ public:
+  int available() override { return rx.size(); }
+  int read() override {
+    if (rx.empty()) {
+      return -1;
+    }
+    uint8_t c = rx.front();
+    rx.pop_front();
+    return c;
+  }
+  size_t write(uint8_t c) override {
+    tx.push_back(c);
+    return 1;
+  }
+  size_t write(const uint8_t* buf, size_t size) override {
+    tx.insert(tx.end(), buf, buf + size);
+    return size;
+  }
+
+  void receive(const Bytes& bytes) {
+    rx.insert(rx.end(), bytes.begin(), bytes.end());
+  }
+
+  std::deque<uint8_t> rx;
+  Bytes tx;
+};
+
+// Link that records request PDUs and returns queued response PDUs.
+class FakeLink : public ModbusLink {
+ public:
+  bool send(const uint8_t* pdu, size_t len) override {
+    requests.emplace_back(pdu, pdu + len);
+    return up;
+  }
+  int receive(uint8_t* pdu) override {
+    if (responses.empty()) {
+      return 0;
+    }
+    Bytes response = responses.front();
+    responses.pop_front();
+    memcpy(pdu, response.data(), response.size());
+    return response.size();
+  }
+  void reset() override { resets++; }
+
+  std::vector<Bytes> requests;
+  std::deque<Bytes> responses;
+  int resets = 0;
+  bool up = true;
+};
+
+// Append the CRC to an RTU frame.
+Bytes with_crc(Bytes frame) {
+  uint16_t crc = ModbusRtuLink::crc16(frame.data(), frame.size());
+  frame.push_back(crc & 0xFF);
+  frame.push_back(crc >> 8);
+  return frame;
+}
+
+// Modbus TCP server behind a Client: each complete request is executed on a
+// bank of coils as it is written, and the response is ready to be read.
+// connect() is called from the link's connect task.
+class ModbusTcpSimulator : public Client {
+ public:
+  static constexpr size_t kNumCoils = 64;
+
+  int connect(const char* host, uint16_t port) override {
+    this->host = host;
+    this->port = port;
+    connections++;
+    is_connected = true;
+    return 1;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t size) override {
+    if (!is_connected) {
+      return 0;
+    }
+    request.insert(request.end(), buf, buf + size);
+    while (request.size() >= 7 &&
+           request.size() >= 6u + ((request[4] << 8) | request[5])) {
+      size_t frame_len = 6 + ((request[4] << 8) | request[5]);
+      execute(Bytes(request.begin(), request.begin() + frame_len));
+      request.erase(request.begin(), request.begin() + frame_len);
+    }
+    return size;
+  }
+  int available() override { return response.size(); }
+  int read() override {
+    if (response.empty()) {
+      return -1;
+    }
+    uint8_t c = response.front();
+    response.pop_front();
+    return c;
+  }
+  int read(uint8_t* buf, size_t size) override {
+    size_t n = std::min(size, response.size());
+    for (size_t i = 0; i < n; i++) {
+      buf[i] = read();
+    }
+    return n;
+  }
+  void stop() override {
+    is_connected = false;
+    request.clear();
+    response.clear();
+  }
+  uint8_t connected() override { return is_connected; }
+
+  bool coils[kNumCoils] = {};
+  // Function code of each request served.
+  Bytes functions;
+  std::vector<uint16_t> transaction_ids;
+  uint8_t unit_id = 0;
+  std::string host;
+  uint16_t port = 0;
+  std::atomic<int> connections{0};
+
+ private:
+  static uint16_t u16(const uint8_t* buf) { return (buf[0] << 8) | buf[1]; }
+
+  void execute(const Bytes& frame) {
+    transaction_ids.push_back(u16(frame.data()));
+    unit_id = frame[6];
+    const uint8_t* pdu = frame.data() + 7;
+    uint8_t function = pdu[0];
+    functions.push_back(function);
+    uint16_t start = u16(pdu + 1);
+    Bytes reply = {function};
+    if (function == 0x01) {
+      uint16_t count = u16(pdu + 3);
+      reply.push_back((count + 7) / 8);
+      reply.resize(2 + (count + 7) / 8);
+      for (int i = 0; i < count; i++) {
+        if (coils[start + i]) {
+          reply[2 + i / 8] |= 1 << (i % 8);
+        }
+      }
+    } else if (function == 0x05) {
+      coils[start] = u16(pdu + 3) == 0xFF00;
+      reply.assign(pdu, pdu + 5);
+    } else if (function == 0x0F) {
+      uint16_t count = u16(pdu + 3);
+      for (int i = 0; i < count; i++) {
+        coils[start + i] = (pdu[6 + i / 8] >> (i % 8)) & 1;
+      }
+      reply.assign(pdu, pdu + 5);
+    } else {
+      reply = {static_cast<uint8_t>(function | 0x80), 0x01};
+    }
+    size_t length = reply.size() + 1;
+    Bytes header = {frame[0], frame[1], 0x00, 0x00,
+                    static_cast<uint8_t>(length >> 8),
+                    static_cast<uint8_t>(length & 0xFF), frame[6]};
+    response.insert(response.end(), header.begin(), header.end());
+    response.insert(response.end(), reply.begin(), reply.end());
+  }
+
+  std::atomic<bool> is_connected{false};
+  Bytes request;
+  std::deque<uint8_t> response;
+};
+
+// The connect task runs on a host thread, in real time.
+bool wait_for_connection(const ModbusTcpLink& link) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!link.is_connected()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+struct Report {
+  int channel;
+  bool state;
+};
+
+}  // namespace
+
+void setUp() { mock::reset(); }
+void tearDown() {}
+
+void test_crc16_reference_vector() {
+  // Read Holding Registers, from the Modbus over serial line guide.
+  const uint8_t frame[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A};
+  TEST_ASSERT_EQUAL_HEX16(0xCDC5, ModbusRtuLink::crc16(frame, sizeof(frame)));
+}
+
+void test_rtu_frames_requests() {
+  MockSerial serial;
+  ModbusRtuLink link(&serial, 1);
+  serial.receive({0x55});  // stale byte, dropped on send
+  const uint8_t pdu[] = {0x03, 0x00, 0x00, 0x00, 0x0A};
+  TEST_ASSERT_TRUE(link.send(pdu, sizeof(pdu)));
+  const uint8_t expected[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD};
+  TEST_ASSERT_EQUAL(sizeof(expected), serial.tx.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, serial.tx.data(), sizeof(expected));
+  TEST_ASSERT_TRUE(serial.rx.empty());
+}
+
+void test_rtu_collects_split_response() {
+  MockSerial serial;
+  ModbusRtuLink link(&serial, 1);
+  Bytes frame = with_crc({0x01, 0x01, 0x01, 0x05});
+  uint8_t pdu[ModbusLink::kMaxPduSize];
+  serial.receive(Bytes(frame.begin(), frame.begin() + 3));
+  TEST_ASSERT_EQUAL(0, link.receive(pdu));
+  serial.receive(Bytes(frame.begin() + 3, frame.end()));
+  TEST_ASSERT_EQUAL(3, link.receive(pdu));
+  const uint8_t expected[] = {0x01, 0x01, 0x05};
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, pdu, sizeof(expected));
+}
+
+void test_rtu_rejects_bad_frames() {
+  MockSerial serial;
+  ModbusRtuLink link(&serial, 1);
+  uint8_t pdu[ModbusLink::kMaxPduSize];
+
+  Bytes corrupted = with_crc({0x01, 0x05, 0x00, 0x10, 0xFF, 0x00});
+  corrupted[4] = 0x00;
+  serial.receive(corrupted);
+  TEST_ASSERT_EQUAL(-1, link.receive(pdu));
+
+  link.reset();
+  serial.rx.clear();
+  serial.receive(with_crc({0x02, 0x05, 0x00, 0x10, 0xFF, 0x00}));
+  TEST_ASSERT_EQUAL(-1, link.receive(pdu));
+}
+
+void test_rtu_exception_response() {
+  MockSerial serial;
+  ModbusRtuLink link(&serial, 1);
+  uint8_t pdu[ModbusLink::kMaxPduSize];
+  serial.receive(with_crc({0x01, 0x8F, 0x02}));
+  TEST_ASSERT_EQUAL(2, link.receive(pdu));
+  TEST_ASSERT_EQUAL_HEX8(0x8F, pdu[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, pdu[1]);
+}
+
+void test_board_reads_back_before_writing() {
+  FakeLink link;
+  ModbusRelayBoard board(&link);
+  std::vector<Report> reports;
+  board.set_state_callback([&reports](int channel, bool state) {
+    reports.push_back({channel, state});
+  });
+  board.add_channel(0, 16);
+  board.add_channel(1, 17);
+  board.add_channel(2, 19);
+  board.command(0, true);
+
+  mock::tick();
+  TEST_ASSERT_EQUAL(1, link.requests.size());
+  const uint8_t read[] = {0x01, 0x00, 0x10, 0x00, 0x04};
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(read, link.requests[0].data(), sizeof(read));
+
+  // Coil 17 is on.
+  link.responses.push_back({0x01, 0x01, 0x02});
+  mock::tick();
+  TEST_ASSERT_EQUAL(3, reports.size());
+  TEST_ASSERT_FALSE(reports[0].state);
+  TEST_ASSERT_TRUE(reports[1].state);
+
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, link.requests.size());
+  const uint8_t write[] = {0x05, 0x00, 0x10, 0xFF, 0x00};
+  TEST_ASSERT_EQUAL(sizeof(write), link.requests[1].size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(write, link.requests[1].data(), sizeof(write));
+
+  link.responses.push_back(link.requests[1]);
+  mock::tick();
+  TEST_ASSERT_EQUAL(4, reports.size());
+  TEST_ASSERT_EQUAL(0, reports[3].channel);
+  TEST_ASSERT_TRUE(reports[3].state);
+}
+
+void test_board_writes_runs_of_commanded_coils() {
+  FakeLink link;
+  ModbusRelayBoard board(&link);
+  board.add_channel(0, 16);
+  board.add_channel(1, 17);
+  board.add_channel(2, 18);
+  board.add_channel(3, 20);
+  mock::tick();
+  link.responses.push_back({0x01, 0x01, 0x02});
+  mock::tick();
+
+  // Coil 18 is left alone, so the commands go out as two runs.
+  board.command(0, true);
+  board.command(1, false);
+  board.command(3, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, link.requests.size());
+  // Coils 16 and 17: 16 on, 17 off.
+  const uint8_t run[] = {0x0F, 0x00, 0x10, 0x00, 0x02, 0x01, 0x01};
+  TEST_ASSERT_EQUAL(sizeof(run), link.requests[1].size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(run, link.requests[1].data(), sizeof(run));
+
+  link.responses.push_back({0x0F, 0x00, 0x10, 0x00, 0x02});
+  mock::tick();
+  mock::tick();
+  TEST_ASSERT_EQUAL(3, link.requests.size());
+  const uint8_t single[] = {0x05, 0x00, 0x14, 0xFF, 0x00};
+  TEST_ASSERT_EQUAL(sizeof(single), link.requests[2].size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(single, link.requests[2].data(),
+                               sizeof(single));
+}
+
+void test_board_rejects_mismatched_write_echo() {
+  FakeLink link;
+  ModbusRelayBoard board(&link, 500, 300, 1000);
+  std::vector<Report> reports;
+  board.set_state_callback([&reports](int channel, bool state) {
+    reports.push_back({channel, state});
+  });
+  board.add_channel(0, 16);
+  board.add_channel(1, 17);
+  mock::tick();
+  link.responses.push_back({0x01, 0x01, 0x00});
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, reports.size());
+
+  board.command(0, true);
+  board.command(1, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, link.requests.size());
+  // The board answers for one coil instead of two.
+  link.responses.push_back({0x0F, 0x00, 0x10, 0x00, 0x01});
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, reports.size());
+
+  // The write is retried after the back-off.
+  mock::advance(500);
+  TEST_ASSERT_EQUAL(3, link.requests.size());
+  TEST_ASSERT_TRUE(link.requests[1] == link.requests[2]);
+  link.responses.push_back({0x0F, 0x00, 0x10, 0x00, 0x02});
+  mock::tick();
+  TEST_ASSERT_EQUAL(4, reports.size());
+  // Published at 1000 ms, after the next poll.
+  link.responses.push_back({0x01, 0x01, 0x03});
+  mock::advance(500);
+  TEST_ASSERT_EQUAL_FLOAT(1, board.errors().get());
+}
+
+void test_board_retries_failed_write_after_backoff() {
+  FakeLink link;
+  ModbusRelayBoard board(&link, 500, 300, 1000);
+  board.add_channel(0, 0);
+  mock::tick();
+  link.responses.push_back({0x01, 0x01, 0x00});
+  mock::tick();
+  board.command(0, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, link.requests.size());
+
+  mock::advance(301);
+  TEST_ASSERT_EQUAL(1, link.resets);
+  mock::advance(498);
+  TEST_ASSERT_EQUAL(2, link.requests.size());
+  mock::advance(2);
+  TEST_ASSERT_EQUAL(3, link.requests.size());
+  TEST_ASSERT_EQUAL_HEX8(0x05, link.requests[2][0]);
+
+  // An exception response fails the write as well.
+  link.responses.push_back({0x85, 0x04});
+  mock::tick();
+  mock::advance(500);
+  TEST_ASSERT_EQUAL(4, link.requests.size());
+  TEST_ASSERT_EQUAL_HEX8(0x05, link.requests[3][0]);
+  // Published at 1000 ms, between the two failures and the last retry.
+  TEST_ASSERT_EQUAL_FLOAT(2, board.errors().get());
+}
+
+void test_tcp_round_trip_with_simulator() {
+  ModbusTcpSimulator simulator;
+  simulator.coils[17] = true;
+  ModbusTcpLink link(&simulator, "relays.local", 502, 3);
+  ModbusRelayBoard board(&link);
+  std::vector<Report> reports;
+  board.set_state_callback([&reports](int channel, bool state) {
+    reports.push_back({channel, state});
+  });
+  board.add_channel(0, 16);
+  board.add_channel(1, 17);
+  board.add_channel(2, 19);
+  board.command(0, true);
+  board.command(2, true);
+
+  // The first request finds the link down and starts the connect task.
+  mock::tick();
+  TEST_ASSERT_TRUE(wait_for_connection(link));
+  TEST_ASSERT_EQUAL_STRING("relays.local", simulator.host.c_str());
+  TEST_ASSERT_EQUAL(502, simulator.port);
+  TEST_ASSERT_TRUE(simulator.functions.empty());
+
+  // FC1 read-back after the back-off, then FC05 for coils 16 and 19; coil
+  // 18 in between is not written.
+  mock::advance(510);
+  const uint8_t functions[] = {0x01, 0x05, 0x05};
+  TEST_ASSERT_EQUAL(sizeof(functions), simulator.functions.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(functions, simulator.functions.data(),
+                               sizeof(functions));
+  TEST_ASSERT_EQUAL_HEX8(3, simulator.unit_id);
+  TEST_ASSERT_EQUAL(1, simulator.transaction_ids[0]);
+  TEST_ASSERT_EQUAL(3, simulator.transaction_ids[2]);
+  TEST_ASSERT_TRUE(simulator.coils[16]);
+  TEST_ASSERT_TRUE(simulator.coils[17]);
+  TEST_ASSERT_FALSE(simulator.coils[18]);
+  TEST_ASSERT_TRUE(simulator.coils[19]);
+
+  // Three channels reported on the read-back, then the two written.
+  TEST_ASSERT_EQUAL(5, reports.size());
+  TEST_ASSERT_FALSE(reports[0].state);
+  TEST_ASSERT_TRUE(reports[1].state);
+  TEST_ASSERT_FALSE(reports[2].state);
+  TEST_ASSERT_EQUAL(0, reports[3].channel);
+  TEST_ASSERT_TRUE(reports[3].state);
+  TEST_ASSERT_EQUAL(2, reports[4].channel);
+  TEST_ASSERT_TRUE(reports[4].state);
+
+  // A coil switched at the board shows up on the next poll.
+  simulator.coils[17] = false;
+  mock::advance(500);
+  TEST_ASSERT_EQUAL(4, simulator.functions.size());
+  TEST_ASSERT_EQUAL(6, reports.size());
+  TEST_ASSERT_EQUAL(1, reports[5].channel);
+  TEST_ASSERT_FALSE(reports[5].state);
+  TEST_ASSERT_EQUAL(1, simulator.connections);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc16_reference_vector);
+  RUN_TEST(test_rtu_frames_requests);
+  RUN_TEST(test_rtu_collects_split_response);
+  RUN_TEST(test_rtu_rejects_bad_frames);
+  RUN_TEST(test_rtu_exception_response);
+  RUN_TEST(test_board_reads_back_before_writing);
+  RUN_TEST(test_board_writes_runs_of_commanded_coils);
+  RUN_TEST(test_board_rejects_mismatched_write_echo);
+  RUN_TEST(test_board_retries_failed_write_after_backoff);
+  RUN_TEST(test_tcp_round_trip_with_simulator);
+  return UNITY_END();
+}
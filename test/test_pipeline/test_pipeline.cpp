@@ -0,0 +1,260 @@
+// End-to-end tests of the relay channel pipeline
+//
+// Channels are wired as main.cpp wires a remote channel: a command goes
+// into the channel store and the transmit queue, the PUT goes to a
+// simulated server, and the state the server reports comes back through
+// the dispatcher into the store, the latency objective, the alarms and the
+// queue. The server answers every PUT after a fixed round trip.
+
+#include <unity.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "alloc_counter.h"
+#include "baselines.h"
+#include "channel_alarms.h"
+#include "channel_store.h"
+#include "latency_slo.h"
+#include "mock.h"
+#include "relay_lease.h"
+#include "state_dispatcher.h"
+#include "transmit_queue.h"
+
+using sensesp::SKPutRequest;
+
+namespace {
+
+// Confirmation latencies of one channel over a whole test; the store's own
+// accumulators are reset by every LatencySlo slice.
+struct Confirmations {
+  void add(int32_t latency_ms) {
+    if (latency_ms < 0) {
+      return;
+    }
+    count++;
+    max_ms = std::max<uint32_t>(max_ms, latency_ms);
+  }
+
+  uint32_t count = 0;
+  uint32_t max_ms = 0;
+};
+
+struct Pipeline {
+  ChannelStore store;
+  StateDispatcher dispatcher;
+  ChannelAlarms alarms{&store};
+  TransmitQueue queue{&store};
+  RelayLease lease;
+  LatencySlo slo{&store, nullptr};
+
+  SKPutRequest<bool>* put_requests[kMaxChannels] = {};
+  std::function<void(bool)> commands[kMaxChannels];
+  Confirmations confirmations[kMaxChannels];
+
+  // The put requests are created up front; their size on the device is
+  // SensESP's business, not the pipeline's.
+  Pipeline() {
+    queue.set_state_dispatcher(&dispatcher);
+    for (int i = 0; i < kMaxChannels; i++) {
+      String path = String("electrical.switches.relay") + String(i) +
+                    ".state";
+      put_requests[i] = new SKPutRequest<bool>(path);
+    }
+  }
+
+  void add_channel(int i, ChannelPriority priority) {
+    SKPutRequest<bool>* put_request = put_requests[i];
+    auto* store_ = &store;
+    auto* slo_ = &slo;
+    auto* alarms_ = &alarms;
+    auto* queue_ = &queue;
+    auto* lease_ = &lease;
+    store.add_channel(i);
+    auto* confirmations_ = &confirmations[i];
+    dispatcher.add_channel(i, priority,
+                           [store_, slo_, alarms_, queue_, confirmations_,
+                            i](bool state) {
+                             int32_t latency = store_->confirm(i, state);
+                             confirmations_->add(latency);
+                             slo_->confirmed(i, latency);
+                             alarms_->state_received(i, state);
+                             queue_->state_received(i, state);
+                           });
+    alarms.add_channel(i, put_request);
+    queue.add_channel(i, put_request, priority);
+    std::function<void(bool)> command = [queue_, lease_, i](bool state) {
+      queue_->enqueue(i);
+      lease_->command_sent(i, state);
+    };
+    commands[i] = [store_, command, i](bool state) {
+      store_->command(i, state);
+      command(state);
+    };
+  }
+
+  void toggle(int i) { commands[i](!store.commanded(i)); }
+
+  int channel_of(const void* sender) const {
+    for (int i = 0; i < kMaxChannels; i++) {
+      if (put_requests[i] == sender) {
+        return i;
+      }
+    }
+    return -1;
+  }
+};
+
+// Answers every PUT with the new state after a fixed round trip, as the
+// listener of the relay's path would see it.
+class FakeServer {
+ public:
+  FakeServer(Pipeline* pipeline, uint32_t rtt_ms)
+      : pipeline_(pipeline), rtt_ms_(rtt_ms) {
+    sensesp::event_loop()->onTick([this]() { tick(); });
+  }
+
+ private:
+  struct Echo {
+    uint64_t due_ms;
+    int channel;
+    bool state;
+  };
+  static constexpr size_t kMaxEchoes = 256;
+
+  void tick() {
+    const auto& puts = mock::puts();
+    for (; seen_ < puts.size(); seen_++) {
+      const mock::Put& put = puts[seen_];
+      echoes_[(head_ + count_++) % kMaxEchoes] = {
+          put.at_ms + rtt_ms_, pipeline_->channel_of(put.sender),
+          put.value != 0};
+    }
+    while (count_ > 0 && echoes_[head_].due_ms <= mock::now_ms()) {
+      const Echo& echo = echoes_[head_];
+      pipeline_->dispatcher.post(echo.channel, echo.state);
+      head_ = (head_ + 1) % kMaxEchoes;
+      count_--;
+    }
+  }
+
+  Pipeline* pipeline_;
+  const uint32_t rtt_ms_;
+  size_t seen_ = 0;
+  Echo echoes_[kMaxEchoes] = {};
+  size_t head_ = 0;
+  size_t count_ = 0;
+};
+
+// Toggle a channel and run the loop until the server confirms it.
+uint32_t toggle_and_wait(Pipeline* pipeline, int channel) {
+  pipeline->toggle(channel);
+  uint64_t start = mock::now_ms();
+  while (pipeline->store.pending()[channel] && mock::now_ms() - start < 10000) {
+    mock::advance(1);
+  }
+  return mock::now_ms() - start;
+}
+
+}  // namespace
+
+void setUp() { mock::reset(); }
+void tearDown() {}
+
+void test_toggle_round_trip() {
+  Pipeline pipeline;
+  FakeServer server(&pipeline, baseline::kServerRttMs);
+  pipeline.add_channel(0, ChannelPriority::kNormal);
+
+  uint32_t latency = toggle_and_wait(&pipeline, 0);
+  TEST_ASSERT_TRUE(pipeline.store.state(0));
+  TEST_ASSERT_EQUAL_UINT32(latency, pipeline.store.latency_max_ms(0));
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kToggleLatencyMs, latency);
+
+  toggle_and_wait(&pipeline, 0);
+  TEST_ASSERT_FALSE(pipeline.store.state(0));
+  TEST_ASSERT_EQUAL(2, mock::puts().size());
+  TEST_ASSERT_FALSE(
+      pipeline.alarms.is_active(ChannelAlarm::kCommandTimeout, 0));
+}
+
+void test_critical_latency_under_low_priority_load() {
+  Pipeline pipeline;
+  FakeServer server(&pipeline, baseline::kServerRttMs);
+  pipeline.add_channel(0, ChannelPriority::kCritical);
+  for (int i = 1; i < kMaxChannels; i++) {
+    pipeline.add_channel(i, ChannelPriority::kLow);
+  }
+
+  // A low-priority channel is toggled every millisecond, far more than the
+  // in-flight window lets through; the critical channel every 250 ms.
+  constexpr uint32_t kDurationMs = 10000;
+  for (uint32_t t = 0; t < kDurationMs; t++) {
+    pipeline.toggle(1 + t % (kMaxChannels - 1));
+    if (t % 250 == 0) {
+      pipeline.toggle(0);
+    }
+    mock::advance(1);
+  }
+  mock::advance(100);
+
+  // The low-priority channels kept their share of the window.
+  uint32_t low_puts = 0;
+  for (const mock::Put& put : mock::puts()) {
+    if (put.sender != pipeline.put_requests[0]) {
+      low_puts++;
+    }
+  }
+  TEST_ASSERT_GREATER_THAN_UINT32(1000, low_puts);
+  TEST_ASSERT_EQUAL_UINT32(kDurationMs / 250,
+                           pipeline.confirmations[0].count);
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kCriticalLatencyUnderLoadMs,
+                              pipeline.confirmations[0].max_ms);
+}
+
+void test_setup_heap_per_channel() {
+  Pipeline pipeline;
+  mock::AllocScope scope;
+  for (int i = 0; i < kMaxChannels; i++) {
+    pipeline.add_channel(i, ChannelPriority::kNormal);
+  }
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kSetupHeapBytesPerChannel,
+                              scope.bytes() / kMaxChannels);
+}
+
+void test_static_ram_per_channel() {
+  size_t bytes = sizeof(ChannelStore) + sizeof(StateDispatcher) +
+                 sizeof(ChannelAlarms) + sizeof(TransmitQueue) +
+                 sizeof(RelayLease) + sizeof(LatencySlo);
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kStaticBytesPerChannel,
+                              bytes / kMaxChannels);
+}
+
+void test_events_do_not_allocate() {
+  Pipeline pipeline;
+  FakeServer server(&pipeline, baseline::kServerRttMs);
+  for (int i = 0; i < kMaxChannels; i++) {
+    pipeline.add_channel(i, ChannelPriority::kNormal);
+  }
+  // Let the first slices and renewals run outside the measurement.
+  mock::advance(1000);
+
+  constexpr int kEvents = 500;
+  mock::AllocScope scope;
+  for (int n = 0; n < kEvents; n++) {
+    toggle_and_wait(&pipeline, n % kMaxChannels);
+  }
+  TEST_ASSERT_EQUAL(kEvents, mock::puts().size());
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kAllocationsPerEvent,
+                              scope.allocations() / kEvents);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_toggle_round_trip);
+  RUN_TEST(test_critical_latency_under_low_priority_load);
+  RUN_TEST(test_setup_heap_per_channel);
+  RUN_TEST(test_static_ram_per_channel);
+  RUN_TEST(test_events_do_not_allocate);
+  return UNITY_END();
+}
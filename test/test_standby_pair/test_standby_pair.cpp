@@ -0,0 +1,199 @@
+#include <unity.h>
+
+#include <memory>
+#include <vector>
+
+#include "channel_alarms.h"
+#include "channel_store.h"
+#include "latency_slo.h"
+#include "mock.h"
+#include "relay_lease.h"
+#include "standby_pair.h"
+
+using namespace sensesp;
+
+namespace {
+
+constexpr int kNumChannels = 4;
+
+struct Command {
+  int channel;
+  bool state;
+};
+
+// One controller of the pair, on its own host of the simulated network.
+struct Node {
+  Node(const char* host, const char* peer_host, uint64_t mac) {
+    mock::udp_network().next_host = host;
+    ESP.efuse_mac = mac;
+    for (int i = 0; i < kNumChannels; i++) {
+      store.add_channel(i);
+      put_requests[i] = std::make_unique<SKPutRequest<bool>>(
+          String("electrical.switches.relay") + String(i) + ".state");
+      lease.add_channel(i, put_requests[i].get());
+      alarms.add_channel(i, put_requests[i].get());
+    }
+    pair = std::make_unique<StandbyPair>(&store, peer_host);
+    // Wired like main.cpp, with the commands recorded.
+    pair->set_role_handler([this](bool active) {
+      roles.push_back(active);
+      lease.hold(active ? store.commanded_states() : ChannelSet());
+    });
+    pair->set_command_handler([this](int channel, bool state) {
+      commands.push_back({channel, state});
+    });
+  }
+
+  // The server echoed a state to this controller's listener.
+  void receive(int channel, bool state) {
+    slo.confirmed(channel, store.confirm(channel, state));
+    alarms.state_received(channel, state);
+  }
+
+  ChannelStore store;
+  RelayLease lease;
+  ChannelAlarms alarms{&store};
+  LatencySlo slo{&store, nullptr};
+  std::unique_ptr<SKPutRequest<bool>> put_requests[kNumChannels];
+  std::unique_ptr<StandbyPair> pair;
+  std::vector<bool> roles;
+  std::vector<Command> commands;
+};
+
+// Count of sent deltas that hold the channel's lease.
+int lease_renewals(int channel) {
+  String path = String("electrical.switches.relay") + String(channel) +
+                ".lease";
+  int count = 0;
+  for (const String& delta : mock::ws_client()->sent()) {
+    if (delta.indexOf(path.c_str()) >= 0 && delta.indexOf("\"ttl\":0") < 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Count of sent deltas that raise an alarm.
+int alerts() {
+  int count = 0;
+  for (const String& delta : mock::ws_client()->sent()) {
+    if (delta.indexOf("\"alert\"") >= 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+void setUp() { mock::reset(); }
+void tearDown() {}
+
+void test_equal_terms_leave_the_lower_node_id_active() {
+  Node a("10.0.0.1", "10.0.0.2", 0x0000000000010000);
+  Node b("10.0.0.2", "10.0.0.1", 0x0000000000020000);
+
+  // Neither hears an active peer, so both take the first term.
+  mock::advance(StandbyPair::kTakeoverMs + StandbyPair::kHeartbeatMs);
+  TEST_ASSERT_TRUE(a.pair->is_active());
+  TEST_ASSERT_FALSE(b.pair->is_active());
+  TEST_ASSERT_EQUAL(1, a.roles.size());
+  TEST_ASSERT_EQUAL(2, b.roles.size());
+  TEST_ASSERT_FALSE(b.roles.back());
+
+  // The standby stays standby while heartbeats arrive.
+  mock::advance(5000);
+  TEST_ASSERT_FALSE(b.pair->is_active());
+  TEST_ASSERT_EQUAL(0, mock::udp_network().dropped);
+}
+
+void test_standby_raises_no_alarm_for_replicated_commands() {
+  Node a("10.0.0.1", "10.0.0.2", 0x0000000000010000);
+  Node b("10.0.0.2", "10.0.0.1", 0x0000000000020000);
+  mock::advance(StandbyPair::kTakeoverMs + StandbyPair::kHeartbeatMs);
+  TEST_ASSERT_FALSE(b.pair->is_active());
+
+  // The standby's store has had no command of its own for a long time.
+  mock::advance(10000);
+  a.store.command(0, true);
+  mock::advance(300);
+  TEST_ASSERT_TRUE(b.store.pending()[0]);
+  TEST_ASSERT_FALSE(b.alarms.is_active(ChannelAlarm::kCommandTimeout, 0));
+
+  a.receive(0, true);
+  b.receive(0, true);
+  mock::advance(300);
+  TEST_ASSERT_FALSE(b.store.pending()[0]);
+  TEST_ASSERT_EQUAL(0, alerts());
+
+  // The standby times the confirmation from the frame, one tick later.
+  TEST_ASSERT_EQUAL_UINT32(300, a.store.latency_max_ms(0));
+  TEST_ASSERT_EQUAL_UINT32(299, b.store.latency_max_ms(0));
+  mock::advance(LatencySlo::kTimeoutMs);
+  TEST_ASSERT_EQUAL_FLOAT(0.3, b.slo.median_latency_s().get());
+
+  // A command that does stay unconfirmed times out on both.
+  a.store.command(1, true);
+  mock::advance(5100);
+  TEST_ASSERT_TRUE(a.alarms.is_active(ChannelAlarm::kCommandTimeout, 1));
+  TEST_ASSERT_TRUE(b.alarms.is_active(ChannelAlarm::kCommandTimeout, 1));
+}
+
+void test_standby_takes_over_after_partition() {
+  Node a("10.0.0.1", "10.0.0.2", 0x0000000000010000);
+  Node b("10.0.0.2", "10.0.0.1", 0x0000000000020000);
+  mock::advance(StandbyPair::kTakeoverMs + StandbyPair::kHeartbeatMs);
+  TEST_ASSERT_TRUE(a.pair->is_active());
+
+  // B's listener sees channel 0 confirmed before A's frame arrives; the
+  // server has not confirmed channels 1 and 2.
+  b.store.confirm(0, true);
+  a.store.command(0, true);
+  a.store.command(1, true);
+  a.store.command(2, true);
+  mock::tick();
+  TEST_ASSERT_TRUE(b.store.pending()[1]);
+  TEST_ASSERT_TRUE(b.store.commanded(2));
+
+  mock::udp_network().down.insert("10.0.0.1");
+  mock::advance(StandbyPair::kTakeoverMs - StandbyPair::kHeartbeatMs);
+  TEST_ASSERT_FALSE(b.pair->is_active());
+  mock::advance(2 * StandbyPair::kHeartbeatMs);
+  TEST_ASSERT_TRUE(b.pair->is_active());
+  float takeover_s = b.pair->takeover_time_s().get();
+  TEST_ASSERT_TRUE(takeover_s >= StandbyPair::kTakeoverMs / 1000.0f);
+  TEST_ASSERT_TRUE(takeover_s <=
+                   (StandbyPair::kTakeoverMs + StandbyPair::kHeartbeatMs) /
+                       1000.0f);
+
+  // Only the unconfirmed commands are resent, after the role change.
+  TEST_ASSERT_TRUE(b.roles.back());
+  TEST_ASSERT_EQUAL(2, b.commands.size());
+  TEST_ASSERT_EQUAL(1, b.commands[0].channel);
+  TEST_ASSERT_TRUE(b.commands[0].state);
+  TEST_ASSERT_EQUAL(2, b.commands[1].channel);
+  TEST_ASSERT_TRUE(b.commands[1].state);
+
+  // B holds the leases of every channel commanded on.
+  TEST_ASSERT_EQUAL(1, lease_renewals(0));
+  TEST_ASSERT_EQUAL(1, lease_renewals(1));
+  TEST_ASSERT_EQUAL(1, lease_renewals(2));
+  TEST_ASSERT_EQUAL(0, lease_renewals(3));
+
+  // A has the older term and steps down once the partition heals.
+  TEST_ASSERT_TRUE(a.pair->is_active());
+  mock::udp_network().down.clear();
+  mock::advance(StandbyPair::kHeartbeatMs);
+  TEST_ASSERT_FALSE(a.pair->is_active());
+  TEST_ASSERT_FALSE(a.roles.back());
+  TEST_ASSERT_TRUE(b.pair->is_active());
+  TEST_ASSERT_EQUAL(2, b.commands.size());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_equal_terms_leave_the_lower_node_id_active);
+  RUN_TEST(test_standby_raises_no_alarm_for_replicated_commands);
+  RUN_TEST(test_standby_takes_over_after_partition);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "alloc_counter.h"
+#include "baselines.h"
+#include "mock.h"
+#include "state_dispatcher.h"
+
+namespace {
+
+struct Handled {
+  int channel;
+  bool state;
+};
+
+std::vector<Handled> handled;
+
+void add_channels(StateDispatcher* dispatcher, int first, int count,
+                  ChannelPriority priority) {
+  for (int i = first; i < first + count; i++) {
+    dispatcher->add_channel(i, priority, [i](bool state) {
+      handled.push_back({i, state});
+    });
+  }
+}
+
+}  // namespace
+
+void setUp() {
+  mock::reset();
+  handled.clear();
+  handled.reserve(1024);
+}
+void tearDown() {}
+
+void test_posts_are_handled_on_the_next_tick() {
+  StateDispatcher dispatcher;
+  add_channels(&dispatcher, 0, 2, ChannelPriority::kNormal);
+  dispatcher.post(1, true);
+  TEST_ASSERT_EQUAL(0, handled.size());
+  mock::tick();
+  TEST_ASSERT_EQUAL(1, handled.size());
+  TEST_ASSERT_EQUAL(1, handled[0].channel);
+  TEST_ASSERT_TRUE(handled[0].state);
+  mock::tick();
+  TEST_ASSERT_EQUAL(1, handled.size());
+}
+
+void test_posts_coalesce_to_the_latest_value() {
+  StateDispatcher dispatcher;
+  add_channels(&dispatcher, 0, 1, ChannelPriority::kNormal);
+  dispatcher.post(0, true);
+  dispatcher.post(0, false);
+  dispatcher.post(0, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(1, handled.size());
+  TEST_ASSERT_TRUE(handled[0].state);
+
+  mock::advance(10000);
+  TEST_ASSERT_EQUAL_FLOAT(2, dispatcher.coalesced().get());
+}
+
+void test_critical_channels_go_first() {
+  StateDispatcher dispatcher(2);
+  add_channels(&dispatcher, 0, 4, ChannelPriority::kLow);
+  add_channels(&dispatcher, 4, 2, ChannelPriority::kNormal);
+  add_channels(&dispatcher, 6, 1, ChannelPriority::kCritical);
+  for (int i = 0; i < 7; i++) {
+    dispatcher.post(i, true);
+  }
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, handled.size());
+  TEST_ASSERT_EQUAL(6, handled[0].channel);
+  TEST_ASSERT_EQUAL(4, handled[1].channel);
+  mock::tick();
+  TEST_ASSERT_EQUAL(5, handled[2].channel);
+  TEST_ASSERT_EQUAL(0, handled[3].channel);
+}
+
+void test_budget_defers_and_rotates() {
+  StateDispatcher dispatcher(4);
+  add_channels(&dispatcher, 0, 10, ChannelPriority::kNormal);
+  for (int i = 0; i < 10; i++) {
+    dispatcher.post(i, true);
+  }
+  mock::tick();
+  TEST_ASSERT_EQUAL(4, handled.size());
+  mock::tick();
+  TEST_ASSERT_EQUAL(8, handled.size());
+  // The next round starts after the last channel handled, so channel 0
+  // does not get ahead of 8 and 9.
+  dispatcher.post(0, false);
+  mock::tick();
+  TEST_ASSERT_EQUAL(11, handled.size());
+  TEST_ASSERT_EQUAL(8, handled[8].channel);
+  TEST_ASSERT_EQUAL(9, handled[9].channel);
+  TEST_ASSERT_EQUAL(0, handled[10].channel);
+
+  mock::advance(10000);
+  TEST_ASSERT_EQUAL_FLOAT(6 + 2, dispatcher.deferred().get());
+}
+
+void test_input_pauses_dispatching() {
+  StateDispatcher dispatcher(4, 60, 200);
+  add_channels(&dispatcher, 0, 1, ChannelPriority::kCritical);
+  dispatcher.input_event();
+  dispatcher.post(0, true);
+  mock::advance(59);
+  TEST_ASSERT_EQUAL(0, handled.size());
+  mock::advance(1);
+  TEST_ASSERT_EQUAL(1, handled.size());
+}
+
+void test_chattering_input_cannot_hold_dispatching() {
+  StateDispatcher dispatcher(4, 60, 200);
+  add_channels(&dispatcher, 0, 1, ChannelPriority::kNormal);
+  dispatcher.post(0, true);
+  uint64_t start = mock::now_ms();
+  // An edge every 10 ms, forever shorter than the guard period.
+  while (handled.empty() && mock::now_ms() - start < 1000) {
+    dispatcher.input_event();
+    mock::advance(10);
+  }
+  TEST_ASSERT_EQUAL(1, handled.size());
+  TEST_ASSERT_UINT32_WITHIN(10, 200, mock::now_ms() - start);
+
+  // After the cap, deltas get a guard period of their own.
+  for (int n = 0; n < 5; n++) {
+    dispatcher.post(0, n & 1);
+    dispatcher.input_event();
+    mock::advance(10);
+  }
+  TEST_ASSERT_EQUAL(6, handled.size());
+}
+
+void test_dispatching_does_not_allocate() {
+  StateDispatcher dispatcher(kMaxChannels);
+  add_channels(&dispatcher, 0, kMaxChannels, ChannelPriority::kNormal);
+  constexpr int kEvents = 1000;
+  mock::AllocScope scope;
+  for (int n = 0; n < kEvents; n++) {
+    dispatcher.post(n % kMaxChannels, n & 1);
+    mock::tick();
+  }
+  TEST_ASSERT_EQUAL(kEvents, handled.size());
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kAllocationsPerEvent,
+                              scope.allocations() / kEvents);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_posts_are_handled_on_the_next_tick);
+  RUN_TEST(test_posts_coalesce_to_the_latest_value);
+  RUN_TEST(test_critical_channels_go_first);
+  RUN_TEST(test_budget_defers_and_rotates);
+  RUN_TEST(test_input_pauses_dispatching);
+  RUN_TEST(test_chattering_input_cannot_hold_dispatching);
+  RUN_TEST(test_dispatching_does_not_allocate);
+  return UNITY_END();
+}
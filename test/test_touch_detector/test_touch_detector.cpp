@@ -0,0 +1,242 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "baselines.h"
+#include "touch_detector.h"
+#include "touch_trace.h"
+
+namespace {
+
+using Event = TouchDetector::Event;
+
+// As in TouchInput.
+constexpr uint32_t kFilterPeriodMs = 10;
+constexpr uint32_t kDriftIntervalMs = 1000;
+// Period of the debounce after TouchInput in main.cpp.
+constexpr uint32_t kDebounceMs = 50;
+
+uint16_t reading;
+uint16_t hardware_threshold;
+
+// A press as the debounced button reports it.
+struct Touch {
+  uint32_t start;
+  uint32_t end;
+  // What touched the pad when the detector reported the touch.
+  Contact contact;
+};
+
+TouchDetector make_detector() {
+  return TouchDetector([]() { return reading; },
+                       [](uint16_t threshold) {
+                         hardware_threshold = threshold;
+                       });
+}
+
+}  // namespace
+
+void setUp() {
+  reading = 1000;
+  hardware_threshold = 0;
+}
+void tearDown() {}
+
+void test_touches_are_ignored_until_calibrated() {
+  TouchDetector detector = make_detector();
+  TEST_ASSERT_FALSE(detector.calibrated());
+  TEST_ASSERT_EQUAL(Event::kNone, detector.update(true, 0));
+  TEST_ASSERT_FALSE(detector.touched());
+}
+
+void test_calibration_sets_threshold_and_release_level() {
+  TouchDetector detector = make_detector();
+  TEST_ASSERT_EQUAL(Event::kNone, detector.track_drift(0));
+  TEST_ASSERT_TRUE(detector.calibrated());
+  TEST_ASSERT_EQUAL_UINT16(1000, detector.baseline());
+  TEST_ASSERT_EQUAL_UINT16(800, detector.threshold());
+  TEST_ASSERT_EQUAL_UINT16(900, detector.release_level());
+  TEST_ASSERT_EQUAL_UINT16(800, hardware_threshold);
+}
+
+void test_release_needs_the_release_level() {
+  TouchDetector detector = make_detector();
+  detector.track_drift(0);
+  reading = 600;
+  TEST_ASSERT_EQUAL(Event::kTouched, detector.update(true, 10));
+  // Further interrupts while touched are not new touches.
+  TEST_ASSERT_EQUAL(Event::kNone, detector.update(true, 20));
+
+  // Above the threshold but below the release level: still touched.
+  reading = 850;
+  TEST_ASSERT_EQUAL(Event::kNone, detector.update(false, 30));
+  TEST_ASSERT_TRUE(detector.touched());
+
+  reading = 900;
+  TEST_ASSERT_EQUAL(Event::kReleased, detector.update(false, 40));
+  TEST_ASSERT_FALSE(detector.touched());
+  TEST_ASSERT_EQUAL(Event::kNone, detector.update(false, 50));
+}
+
+void test_baseline_follows_drift() {
+  TouchDetector detector = make_detector();
+  detector.track_drift(0);
+  reading = 1080;
+  detector.track_drift(1000);
+  TEST_ASSERT_EQUAL_UINT16(1010, detector.baseline());
+  for (int n = 0; n < 100; n++) {
+    detector.track_drift(2000 + n * 1000);
+  }
+  TEST_ASSERT_UINT16_WITHIN(8, 1080, detector.baseline());
+  TEST_ASSERT_EQUAL_UINT16(detector.threshold(), hardware_threshold);
+}
+
+void test_drift_is_not_tracked_while_touched() {
+  TouchDetector detector = make_detector();
+  detector.track_drift(0);
+  reading = 500;
+  detector.update(true, 100);
+  TEST_ASSERT_EQUAL(Event::kNone, detector.track_drift(1000));
+  TEST_ASSERT_EQUAL_UINT16(1000, detector.baseline());
+}
+
+void test_stuck_touch_recalibrates() {
+  TouchDetector detector = make_detector();
+  detector.track_drift(0);
+  reading = 700;
+  detector.update(true, 100);
+  TEST_ASSERT_EQUAL(Event::kNone,
+                    detector.track_drift(100 + TouchDetector::kStuckMs - 1));
+  TEST_ASSERT_EQUAL(Event::kReleased,
+                    detector.track_drift(100 + TouchDetector::kStuckMs));
+  TEST_ASSERT_FALSE(detector.touched());
+  TEST_ASSERT_EQUAL_UINT16(700, detector.baseline());
+  TEST_ASSERT_EQUAL_UINT16(560, hardware_threshold);
+}
+
+// Replays the trace and debounces the events like main.cpp does. A fast
+// edge can end a touch on the next tick, while the filtered reading still
+// lags the raw one, and the next measurement starts it again; that and the
+// noise spikes end well within the debounce period. The time from each
+// finger landing to its debounced press, and the rate of raw touches while
+// only noise is on the pad, are checked against the stored baselines.
+void test_replayed_trace_has_no_chatter() {
+  TouchDetector detector = make_detector();
+  int expected_presses = 0;
+  Contact previous = Contact::kNone;
+  // The software filter is modelled as an IIR filter of factor 4.
+  uint32_t filtered = kTouchTrace[0].from;
+  uint32_t noise_state = 1;
+  bool triggered = false;
+  uint32_t now = 0;
+
+  int raw_touches = 0;
+  // Raw touches while nothing but noise was on the pad.
+  int false_triggers = 0;
+  // When each finger or cloth contact began.
+  std::vector<uint32_t> onsets;
+  bool touched = false;
+  uint32_t changed_at = 0;
+  Contact touch_contact = Contact::kNone;
+  std::vector<Touch> presses;
+
+  for (const TraceSegment& segment : kTouchTrace) {
+    if (segment.contact != previous &&
+        (segment.contact == Contact::kFinger ||
+         segment.contact == Contact::kCloth)) {
+      expected_presses++;
+      onsets.push_back(now);
+    }
+    previous = segment.contact;
+    for (uint32_t t = 0; t < segment.duration_ms; t++, now++) {
+      auto record = [&](TouchDetector::Event event) {
+        if (event == Event::kTouched) {
+          raw_touches++;
+          if (segment.contact != Contact::kFinger &&
+              segment.contact != Contact::kCloth) {
+            false_triggers++;
+          }
+          touched = true;
+          changed_at = now;
+          touch_contact = segment.contact;
+        } else if (event == Event::kReleased) {
+          touched = false;
+          changed_at = now;
+        }
+      };
+      if (now % kDriftIntervalMs == 0) {
+        record(detector.track_drift(now));
+      }
+      // Measurements are out of phase with the drift updates.
+      if (now % kFilterPeriodMs == kFilterPeriodMs / 2) {
+        int level = segment.from + (segment.to - segment.from) *
+                                       static_cast<int>(t) /
+                                       static_cast<int>(segment.duration_ms);
+        noise_state = noise_state * 1103515245 + 12345;
+        int noise = static_cast<int>((noise_state >> 16) %
+                                     (2 * segment.noise + 1)) -
+                    segment.noise;
+        uint16_t raw = level + noise;
+        filtered = (filtered * 3 + raw) / 4;
+        reading = filtered;
+        // The threshold interrupt compares the raw reading.
+        triggered |= raw < hardware_threshold;
+      }
+      record(detector.update(triggered, now));
+      triggered = false;
+
+      bool pressed = !presses.empty() && presses.back().end == 0;
+      if (touched != pressed && now - changed_at >= kDebounceMs) {
+        if (touched) {
+          presses.push_back({now, 0, touch_contact});
+        } else {
+          presses.back().end = now;
+        }
+      }
+    }
+  }
+
+  // One press per finger and one for the cloth; nothing for the hovering
+  // hand, the water film or the spikes.
+  TEST_ASSERT_EQUAL(6, expected_presses);
+  TEST_ASSERT_EQUAL(expected_presses, presses.size());
+  TEST_ASSERT_GREATER_THAN(expected_presses, raw_touches);
+  uint32_t max_latency_ms = 0;
+  for (size_t i = 0; i < presses.size(); i++) {
+    const Touch& press = presses[i];
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(onsets[i], press.start);
+    // The cloth settles slowly; the latency that matters is a finger's.
+    if (press.contact == Contact::kFinger) {
+      max_latency_ms = std::max(max_latency_ms, press.start - onsets[i]);
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(press.start, press.end);
+    TEST_ASSERT_TRUE(press.contact == Contact::kFinger ||
+                     press.contact == Contact::kCloth);
+    if (press.contact == Contact::kCloth) {
+      // Released by recalibration on the first drift update after kStuckMs.
+      TEST_ASSERT_UINT32_WITHIN(kDriftIntervalMs / 2,
+                                TouchDetector::kStuckMs + kDriftIntervalMs / 2,
+                                press.end - press.start);
+    }
+  }
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kTouchDetectionLatencyMs,
+                              max_latency_ms);
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kTouchFalseTriggersPerHour,
+                              false_triggers * 3600000ull / now);
+  TEST_ASSERT_FALSE(detector.touched());
+  TEST_ASSERT_UINT16_WITHIN(10, 1000, detector.baseline());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_touches_are_ignored_until_calibrated);
+  RUN_TEST(test_calibration_sets_threshold_and_release_level);
+  RUN_TEST(test_release_needs_the_release_level);
+  RUN_TEST(test_baseline_follows_drift);
+  RUN_TEST(test_drift_is_not_tracked_while_touched);
+  RUN_TEST(test_stuck_touch_recalibrates);
+  RUN_TEST(test_replayed_trace_has_no_chatter);
+  return UNITY_END();
+}
@@ -0,0 +1,81 @@
+// Raw readings of a touch v1 pad, for replaying through TouchDetector
+//
+// The trace is a script of segments over which the raw reading ramps
+// linearly from one level to another, with uniform noise of the given
+// amplitude on top. It models a pad with an untouched reading around 1000
+// and the cases the detector has to tell apart: finger taps and holds, a
+// finger resting just past the threshold, a hand hovering above the pad,
+// single-sample noise spikes, a water film that builds up and dries off
+// again, and a wet cloth left on the pad. Each segment says what touches
+// the pad, so the replay can check the events against it.
+
+#ifndef TOUCH_TRACE_H_
+#define TOUCH_TRACE_H_
+
+#include <cstdint>
+
+enum class Contact : uint8_t { kNone, kFinger, kSpike, kCloth };
+
+struct TraceSegment {
+  uint32_t duration_ms;
+  uint16_t from;
+  uint16_t to;
+  uint16_t noise;
+  Contact contact;
+};
+
+constexpr TraceSegment kTouchTrace[] = {
+    // Untouched while the pad calibrates.
+    {2000, 1000, 1000, 12, Contact::kNone},
+    // Tap.
+    {30, 1000, 620, 12, Contact::kFinger},
+    {120, 620, 620, 12, Contact::kFinger},
+    {30, 620, 1000, 12, Contact::kFinger},
+    {1500, 1000, 1000, 12, Contact::kNone},
+    // Hold.
+    {40, 1000, 600, 12, Contact::kFinger},
+    {2000, 600, 600, 12, Contact::kFinger},
+    {40, 600, 1000, 12, Contact::kFinger},
+    {1500, 1000, 1000, 12, Contact::kNone},
+    // Noise spikes of one raw sample.
+    {10, 760, 760, 0, Contact::kSpike},
+    {800, 1000, 1000, 12, Contact::kNone},
+    {10, 740, 740, 0, Contact::kSpike},
+    {1200, 1000, 1000, 12, Contact::kNone},
+    // Hand hovering above the pad, short of the threshold.
+    {30, 1000, 860, 12, Contact::kNone},
+    {500, 860, 860, 12, Contact::kNone},
+    {30, 860, 1000, 12, Contact::kNone},
+    {1000, 1000, 1000, 12, Contact::kNone},
+    // Finger resting lightly: the reading wanders across the threshold as
+    // the pressure changes.
+    {40, 1000, 790, 15, Contact::kFinger},
+    {300, 790, 790, 15, Contact::kFinger},
+    {150, 790, 830, 15, Contact::kFinger},
+    {300, 830, 830, 15, Contact::kFinger},
+    {150, 830, 785, 15, Contact::kFinger},
+    {300, 785, 785, 15, Contact::kFinger},
+    {40, 785, 1000, 15, Contact::kFinger},
+    {1500, 1000, 1000, 12, Contact::kNone},
+    // Water film building up, a tap through it, and the film drying off.
+    {20000, 1000, 880, 12, Contact::kNone},
+    {4000, 880, 880, 12, Contact::kNone},
+    {30, 880, 540, 12, Contact::kFinger},
+    {200, 540, 540, 12, Contact::kFinger},
+    {30, 540, 880, 12, Contact::kFinger},
+    {4000, 880, 880, 12, Contact::kNone},
+    {20000, 880, 1000, 12, Contact::kNone},
+    {3000, 1000, 1000, 12, Contact::kNone},
+    // Wet cloth left on the pad, then taken away.
+    {200, 1000, 700, 12, Contact::kCloth},
+    {40000, 700, 700, 12, Contact::kCloth},
+    {200, 700, 1000, 12, Contact::kCloth},
+    // Untouched while the baseline recovers, then a last tap.
+    {40000, 1000, 1000, 12, Contact::kNone},
+    {30, 1000, 620, 12, Contact::kFinger},
+    {120, 620, 620, 12, Contact::kFinger},
+    {30, 620, 1000, 12, Contact::kFinger},
+    {2000, 1000, 1000, 12, Contact::kNone},
+};
+
+#endif  // TOUCH_TRACE_H_
@@ -0,0 +1,282 @@
+#include <unity.h>
+
+#include "alloc_counter.h"
+#include "baselines.h"
+#include "channel_store.h"
+#include "compact_commands.h"
+#include "connection_monitor.h"
+#include "link_quality.h"
+#include "mock.h"
+#include "state_dispatcher.h"
+#include "transmit_queue.h"
+
+using sensesp::SKPutRequest;
+
+namespace {
+
+SKPutRequest<bool>* put_requests[kMaxChannels];
+
+SKPutRequest<bool>* put_request(int channel) {
+  if (put_requests[channel] == nullptr) {
+    String path = String("electrical.switches.relay") + String(channel) +
+                  ".state";
+    put_requests[channel] = new SKPutRequest<bool>(path);
+  }
+  return put_requests[channel];
+}
+
+void add_channel(ChannelStore* store, TransmitQueue* queue, int channel,
+                 ChannelPriority priority) {
+  store->add_channel(channel);
+  queue->add_channel(channel, put_request(channel), priority);
+}
+
+void command(ChannelStore* store, TransmitQueue* queue, int channel,
+             bool state) {
+  store->command(channel, state);
+  queue->enqueue(channel);
+}
+
+// The listener reports the state the server now has.
+void confirm(ChannelStore* store, TransmitQueue* queue, int channel,
+             bool state) {
+  store->confirm(channel, state);
+  queue->state_received(channel, state);
+}
+
+size_t puts_to(int channel) {
+  size_t count = 0;
+  String path = put_request(channel)->get_sk_path();
+  for (const mock::Put& put : mock::puts()) {
+    if (path == put.path) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+void setUp() { mock::reset(); }
+void tearDown() {}
+
+void test_sends_the_commanded_state() {
+  ChannelStore store;
+  TransmitQueue queue(&store);
+  add_channel(&store, &queue, 2, ChannelPriority::kNormal);
+  command(&store, &queue, 2, true);
+  TEST_ASSERT_EQUAL(1, queue.depth());
+  mock::tick();
+  TEST_ASSERT_EQUAL(0, queue.depth());
+  TEST_ASSERT_EQUAL(1, mock::puts().size());
+  TEST_ASSERT_EQUAL_STRING("electrical.switches.relay2.state",
+                           mock::puts()[0].path);
+  TEST_ASSERT_EQUAL_FLOAT(1, mock::puts()[0].value);
+}
+
+void test_newer_command_replaces_pending_one() {
+  ChannelStore store;
+  TransmitQueue queue(&store);
+  add_channel(&store, &queue, 0, ChannelPriority::kNormal);
+  mock::ws_client()->set_state(
+      sensesp::SKWSConnectionState::kSKWSDisconnected);
+  command(&store, &queue, 0, true);
+  command(&store, &queue, 0, false);
+  command(&store, &queue, 0, true);
+  mock::advance(100);
+  TEST_ASSERT_EQUAL(0, mock::puts().size());
+
+  mock::ws_client()->set_state(sensesp::SKWSConnectionState::kSKWSConnected);
+  mock::tick();
+  TEST_ASSERT_EQUAL(1, mock::puts().size());
+  TEST_ASSERT_EQUAL_FLOAT(1, mock::puts()[0].value);
+  mock::advance(10000);
+  TEST_ASSERT_EQUAL_FLOAT(2, queue.superseded().get());
+}
+
+void test_one_put_in_flight_per_channel() {
+  ChannelStore store;
+  TransmitQueue queue(&store);
+  add_channel(&store, &queue, 0, ChannelPriority::kNormal);
+  command(&store, &queue, 0, true);
+  mock::tick();
+  command(&store, &queue, 0, false);
+  mock::advance(100);
+  TEST_ASSERT_EQUAL(1, mock::puts().size());
+
+  confirm(&store, &queue, 0, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, mock::puts().size());
+  TEST_ASSERT_EQUAL_FLOAT(0, mock::puts()[1].value);
+}
+
+void test_command_matching_the_value_in_flight_is_not_resent() {
+  ChannelStore store;
+  TransmitQueue queue(&store);
+  add_channel(&store, &queue, 0, ChannelPriority::kNormal);
+  command(&store, &queue, 0, true);
+  mock::tick();
+  command(&store, &queue, 0, false);
+  command(&store, &queue, 0, true);
+  TEST_ASSERT_EQUAL(0, queue.depth());
+  confirm(&store, &queue, 0, true);
+  mock::advance(100);
+  TEST_ASSERT_EQUAL(1, mock::puts().size());
+}
+
+void test_critical_channels_keep_a_slot() {
+  ChannelStore store;
+  TransmitQueue queue(&store, 4);
+  for (int i = 0; i < 8; i++) {
+    add_channel(&store, &queue, i, ChannelPriority::kLow);
+  }
+  add_channel(&store, &queue, 8, ChannelPriority::kCritical);
+  for (int i = 0; i < 8; i++) {
+    command(&store, &queue, i, true);
+  }
+  mock::tick();
+  TEST_ASSERT_EQUAL(3, mock::puts().size());
+
+  command(&store, &queue, 8, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(4, mock::puts().size());
+  TEST_ASSERT_EQUAL(1, puts_to(8));
+}
+
+void test_unconfirmed_put_is_retried() {
+  ChannelStore store;
+  TransmitQueue queue(&store, 4, 2);
+  add_channel(&store, &queue, 0, ChannelPriority::kCritical);
+  command(&store, &queue, 0, true);
+  mock::tick();
+  uint32_t timeout =
+      kAckTimeoutMs[static_cast<int>(ChannelPriority::kCritical)];
+  mock::advance(timeout);
+  TEST_ASSERT_EQUAL(1, mock::puts().size());
+  // Expiry runs every 50 ms.
+  mock::advance(50);
+  TEST_ASSERT_EQUAL(2, mock::puts().size());
+
+  // After max_retries, the queue gives up; the store keeps it pending.
+  mock::advance(10 * timeout);
+  TEST_ASSERT_EQUAL(3, mock::puts().size());
+  TEST_ASSERT_TRUE(store.pending()[0]);
+}
+
+void test_round_trips_skip_retried_puts() {
+  ChannelStore store;
+  ConnectionMonitor connection;
+  LinkQuality link_quality(&connection);
+  TransmitQueue queue(&store, 4, 2);
+  queue.set_link_quality(&link_quality);
+  add_channel(&store, &queue, 0, ChannelPriority::kCritical);
+  command(&store, &queue, 0, true);
+  mock::tick();
+  uint32_t timeout =
+      kAckTimeoutMs[static_cast<int>(ChannelPriority::kCritical)];
+  mock::advance(timeout + 50);
+  TEST_ASSERT_EQUAL(2, mock::puts().size());
+
+  // The confirmation could answer either PUT, so it gives no sample.
+  mock::advance(100);
+  confirm(&store, &queue, 0, true);
+  mock::advance(1000);
+  TEST_ASSERT_EQUAL_FLOAT(0, link_quality.rtt_s().get());
+
+  // A PUT confirmed on the first try is timed to the arrival of the delta,
+  // not to its dispatch after the button input.
+  StateDispatcher dispatcher;
+  dispatcher.add_channel(0, ChannelPriority::kCritical, [&](bool state) {
+    confirm(&store, &queue, 0, state);
+  });
+  queue.set_state_dispatcher(&dispatcher);
+  command(&store, &queue, 0, false);
+  mock::tick();
+  mock::advance(30);
+  dispatcher.input_event();
+  dispatcher.post(0, false);
+  mock::advance(1000);
+  TEST_ASSERT_FALSE(store.pending()[0]);
+  TEST_ASSERT_EQUAL_FLOAT(0.03, link_quality.rtt_s().get());
+}
+
+void test_compact_commands_batch_a_tick() {
+  ChannelStore store;
+  CompactCommands compact;
+  TransmitQueue queue(&store);
+  queue.set_compact_commands(&compact);
+  for (int i = 0; i < 3; i++) {
+    add_channel(&store, &queue, i, ChannelPriority::kNormal);
+    compact.add_channel(i, put_request(i));
+  }
+  mock::tick();
+  TEST_ASSERT_EQUAL(1, mock::requests().size());
+  JsonDocument& hello = *mock::requests()[0].request;
+  TEST_ASSERT_EQUAL_STRING("remoteRelay.hello",
+                           hello["put"]["path"].as<const char*>());
+  TEST_ASSERT_EQUAL(3, hello["put"]["value"]["paths"].size());
+  mock::respond(0, 200);
+  TEST_ASSERT_TRUE(compact.active());
+
+  command(&store, &queue, 0, true);
+  command(&store, &queue, 2, false);
+  mock::tick();
+  TEST_ASSERT_EQUAL(0, mock::puts().size());
+  TEST_ASSERT_EQUAL(2, mock::requests().size());
+  JsonDocument& batch = *mock::requests()[1].request;
+  TEST_ASSERT_EQUAL_STRING("remoteRelay.command",
+                           batch["put"]["path"].as<const char*>());
+  String encoded;
+  serializeJson(batch["put"]["value"]["c"], encoded);
+  TEST_ASSERT_EQUAL_STRING("[1,4]", encoded.c_str());
+  confirm(&store, &queue, 0, true);
+  confirm(&store, &queue, 2, false);
+
+  // A single command goes out as a plain PUT.
+  command(&store, &queue, 1, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, mock::requests().size());
+  TEST_ASSERT_EQUAL(1, puts_to(1));
+
+  // Without the plugin, plain PUTs again.
+  compact.fall_back();
+  command(&store, &queue, 0, false);
+  command(&store, &queue, 2, true);
+  mock::tick();
+  TEST_ASSERT_EQUAL(2, mock::requests().size());
+  TEST_ASSERT_EQUAL(3, mock::puts().size());
+}
+
+void test_plain_puts_do_not_allocate() {
+  ChannelStore store;
+  TransmitQueue queue(&store, kMaxChannels);
+  for (int i = 0; i < kMaxChannels; i++) {
+    add_channel(&store, &queue, i, ChannelPriority::kNormal);
+  }
+  constexpr int kEvents = 1000;
+  mock::AllocScope scope;
+  for (int n = 0; n < kEvents; n++) {
+    int channel = n % kMaxChannels;
+    bool state = (n / kMaxChannels) & 1;
+    command(&store, &queue, channel, state);
+    mock::tick();
+    confirm(&store, &queue, channel, state);
+  }
+  TEST_ASSERT_EQUAL(kEvents, mock::puts().size());
+  TEST_ASSERT_WITHIN_BASELINE(baseline::kAllocationsPerEvent,
+                              scope.allocations() / kEvents);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sends_the_commanded_state);
+  RUN_TEST(test_newer_command_replaces_pending_one);
+  RUN_TEST(test_one_put_in_flight_per_channel);
+  RUN_TEST(test_command_matching_the_value_in_flight_is_not_resent);
+  RUN_TEST(test_critical_channels_keep_a_slot);
+  RUN_TEST(test_unconfirmed_put_is_retried);
+  RUN_TEST(test_round_trips_skip_retried_puts);
+  RUN_TEST(test_compact_commands_batch_a_tick);
+  RUN_TEST(test_plain_puts_do_not_allocate);
+  return UNITY_END();
+}
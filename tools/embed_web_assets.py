@@ -0,0 +1,91 @@
+"""Embed the files in web/ into the firmware as gzip-compressed arrays.
+
+Generates src/web_assets_autogen.h with one WebAsset entry per file,
+served under /relays/. Each entry carries a strong ETag derived from the
+file contents. Runs as a PlatformIO pre-build script and can also be run
+directly: python tools/embed_web_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+}
+
+URL_PREFIX = "/relays/"
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821  (defined by PlatformIO)
+        return env["PROJECT_DIR"]  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def symbol_for(name):
+    return "kWebAsset_" + "".join(c if c.isalnum() else "_" for c in name)
+
+
+def generate(root):
+    web_dir = os.path.join(root, "web")
+    out_path = os.path.join(root, "src", "web_assets_autogen.h")
+    names = sorted(
+        os.path.relpath(os.path.join(d, f), web_dir).replace(os.sep, "/")
+        for d, _, files in os.walk(web_dir)
+        for f in files
+    )
+
+    lines = [
+        "// Generated by tools/embed_web_assets.py from web/. Do not edit.",
+        "",
+        "#ifndef WEB_ASSETS_AUTOGEN_H_",
+        "#define WEB_ASSETS_AUTOGEN_H_",
+        "",
+        '#include "web_assets.h"',
+        "",
+    ]
+    entries = []
+    for name in names:
+        with open(os.path.join(web_dir, name), "rb") as f:
+            raw = f.read()
+        # mtime=0 keeps the output, and thus the ETag, reproducible.
+        data = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '\\"' + hashlib.sha256(raw).hexdigest()[:16] + '\\"'
+        ext = os.path.splitext(name)[1]
+        content_type = CONTENT_TYPES.get(ext, "application/octet-stream")
+        symbol = symbol_for(name)
+        lines.append("static const uint8_t %s[] = {" % symbol)
+        for i in range(0, len(data), 16):
+            chunk = ", ".join("0x%02x" % b for b in data[i:i + 16])
+            lines.append("    %s," % chunk)
+        lines.append("};")
+        lines.append("")
+        uri = URL_PREFIX + ("" if name == "index.html" else name)
+        entries.append('    {"%s", "%s", "%s", %s, sizeof(%s)},' %
+                       (uri, content_type, etag, symbol, symbol))
+
+    lines.append("static const WebAsset kWebAssets[] = {")
+    lines.extend(entries)
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif  // WEB_ASSETS_AUTOGEN_H_")
+    lines.append("")
+    content = "\n".join(lines)
+
+    if os.path.exists(out_path):
+        with open(out_path) as f:
+            if f.read() == content:
+                return
+    with open(out_path, "w") as f:
+        f.write(content)
+
+
+generate(project_dir())
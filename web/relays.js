@@ -0,0 +1,64 @@
+// Virtual control panel: shows every channel as a button and sends
+// commands over a websocket to the controller (port 81). A ?token= on the
+// page URL is passed on to the websocket.
+(function () {
+  const token = new URLSearchParams(location.search).get('token');
+  const container = document.getElementById('channels');
+  const buttons = [];
+  let socket = null;
+
+  function render(names) {
+    container.textContent = '';
+    buttons.length = 0;
+    names.forEach((name, channel) => {
+      if (name === null) {
+        buttons.push(null);
+        return;
+      }
+      const button = document.createElement('button');
+      button.className = 'channel';
+      button.textContent = name;
+      button.addEventListener('click', () => {
+        const on = button.classList.contains('on');
+        if (socket && socket.readyState === WebSocket.OPEN) {
+          socket.send(String(channel * 2 + (on ? 0 : 1)));
+          button.classList.add('pending');
+        }
+      });
+      container.appendChild(button);
+      buttons.push(button);
+    });
+  }
+
+  function update(states) {
+    states.forEach((state, channel) => {
+      const button = buttons[channel];
+      if (button) {
+        button.classList.toggle('on', state === true);
+        button.classList.remove('pending');
+      }
+    });
+  }
+
+  function connect() {
+    let url = 'ws://' + location.hostname + ':81/relays/ws';
+    if (token) {
+      url += '?token=' + encodeURIComponent(token);
+    }
+    socket = new WebSocket(url);
+    socket.onmessage = (event) => {
+      const message = JSON.parse(event.data);
+      if (message.names) {
+        render(message.names);
+      }
+      update(message.states);
+    };
+    socket.onclose = () => {
+      document.body.classList.add('offline');
+      setTimeout(connect, 2000);
+    };
+    socket.onopen = () => document.body.classList.remove('offline');
+  }
+
+  connect();
+})();